@@ -0,0 +1,174 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include <launch.hh>
+#include <rocket.hh>
+#include <runner.hh>
+#include <scenario.hh>
+#include <telemetry.hh>
+#include <universe.hh>
+#include <world.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Run the launch from the view without a display and print the rocket's state.
+//
+// loft-run [-d duration] [-s step] [-w warp] [-p interval] [-t telemetry]
+//          [-f scenario | name=value ...]
+//
+// The scenario advances with a fixed step as fast as possible unless a warp (simulated
+// seconds per real second) is given.  The state is printed every interval seconds of
+// simulated time.  With -t, the rocket's telemetry is logged every step, in binary if the
+// file name ends with ".bin" and as CSV otherwise.  Launch parameters may be changed with
+// name=value.  With -f, the scenario file is run instead.  It must have a rocket named
+// "rocket" and a world named "earth".
+
+void usage()
+{
+    std::cerr << "usage: loft-run [-d duration] [-s step] [-w warp] [-p interval] "
+              << "[-t telemetry]\n                [-f scenario | name=value ...]\n"
+              << "parameters:";
+    for (auto const& name : Launch::names())
+        std::cerr << ' ' << name;
+    std::cerr << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    double duration{600.0};
+    double step{0.1};
+    double warp{0.0};
+    double interval{10.0};
+    std::string telemetry_path;
+    std::string scenario_path;
+    bool parameters{false};
+    Launch launch;
+
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (std::size_t i = 0; i < args.size(); ++i)
+    {
+        auto const& arg{args[i]};
+        auto has_value{i + 1 < args.size()};
+        try
+        {
+            if (arg == "-d" && has_value)
+                duration = std::stod(args[++i]);
+            else if (arg == "-s" && has_value)
+                step = std::stod(args[++i]);
+            else if (arg == "-w" && has_value)
+                warp = std::stod(args[++i]);
+            else if (arg == "-p" && has_value)
+                interval = std::stod(args[++i]);
+            else if (arg == "-t" && has_value)
+                telemetry_path = args[++i];
+            else if (arg == "-f" && has_value)
+                scenario_path = args[++i];
+            else if (auto eq{arg.find('=')}; arg[0] != '-' && eq != std::string::npos)
+            {
+                if (!launch.set(arg.substr(0, eq), std::stod(arg.substr(eq + 1))))
+                {
+                    std::cerr << "loft-run: bad parameter: " << arg << std::endl;
+                    return 1;
+                }
+                parameters = true;
+            }
+            else
+            {
+                usage();
+                return 1;
+            }
+        }
+        catch (std::exception const&)
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (step <= 0.0 || (parameters && !scenario_path.empty()))
+    {
+        usage();
+        return 1;
+    }
+
+    Member member;
+    if (scenario_path.empty())
+        member = launch.build();
+    else
+    {
+        std::string error;
+        auto scenario{Scenario::load(scenario_path, &error)};
+        if (!scenario)
+        {
+            std::cerr << "loft-run: " << scenario_path << ": " << error << std::endl;
+            return 1;
+        }
+        member = {scenario->universe(), scenario->get<World>("earth"),
+                  scenario->get<Rocket>("rocket"), {}};
+        if (!member.world || !member.probe)
+        {
+            std::cerr << "loft-run: " << scenario_path << ": needs earth and rocket"
+                      << std::endl;
+            return 1;
+        }
+    }
+    auto rocket{std::dynamic_pointer_cast<Rocket>(member.probe)};
+    auto world{member.world};
+    Runner runner(*member.universe, step);
+    runner.set_pacing(warp);
+    if (member.control)
+        runner.observe(member.control);
+
+    std::unique_ptr<Telemetry> telemetry;
+    std::unique_ptr<Body_Telemetry> rocket_telemetry;
+    if (!telemetry_path.empty())
+    {
+        auto binary{telemetry_path.ends_with(".bin")};
+        telemetry = std::make_unique<Telemetry>(
+            telemetry_path, binary ? Telemetry::Format::binary : Telemetry::Format::csv);
+        if (!telemetry->is_open())
+        {
+            std::cerr << "loft-run: can't write " << telemetry_path << std::endl;
+            return 1;
+        }
+        rocket_telemetry = std::make_unique<Body_Telemetry>(*telemetry, "rocket", rocket,
+                                                            world);
+        runner.observe([&](Universe& all) { rocket_telemetry->observe(all); });
+    }
+
+    auto every{std::max<long>(1, std::lround(interval/step))};
+    long n{0};
+    std::cout << "# time lat lon alt speed fuel\n" << std::setprecision(9);
+    runner.observe([&](Universe& all) {
+        if (++n % every != 0)
+            return;
+        // The rocket's position is relative to the world until it's released.
+        auto r{rocket->is_free() ? rocket->r_cm() : world->transform_out(rocket->r())};
+        auto [lat, lon, alt] = world->location(r);
+        std::cout << all.time() << ' ' << lat << ' ' << lon << ' ' << alt << ' '
+                  << mag(rocket->v_cm() - world->v_cm()) << ' ' << rocket->fuel_volume()
+                  << std::endl;
+    });
+    runner.run(duration);
+    if (telemetry && telemetry->dropped() > 0)
+        std::cerr << "loft-run: dropped " << telemetry->dropped() << " telemetry values"
+                  << std::endl;
+    return 0;
+}
@@ -0,0 +1,210 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include <ensemble.hh>
+#include <launch.hh>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Run a launch for every combination of parameter values and print a table of outcomes.
+//
+// loft-sweep [-j threads] [-d duration] [-s step] [-o output] [template] [name=values ...]
+//
+// The template file has a parameter name and values on each line.  Values are either a
+// single number or start:stop:count for count evenly spaced values.  Parameters given on
+// the command line as name=values override the template.  Lines starting with # are
+// ignored.  Parameters that aren't mentioned keep the defaults from the view.
+
+/// A parameter and the values it takes in the sweep.
+struct Axis
+{
+    std::string name;
+    std::vector<double> values;
+};
+
+void usage()
+{
+    std::cerr << "usage: loft-sweep [-j threads] [-d duration] [-s step] [-o output] "
+              << "[template] [name=start:stop:count ...]\nparameters:";
+    for (auto const& name : Launch::names())
+        std::cerr << ' ' << name;
+    std::cerr << std::endl;
+}
+
+/// Parse a single value or a start:stop:count range.
+/// @return False if the string is not a valid value or range.
+bool parse_values(std::string const& spec, std::vector<double>& values)
+{
+    values.clear();
+    std::istringstream is(spec);
+    double start, stop;
+    int count;
+    char c1, c2;
+    if (!(is >> start))
+        return false;
+    if (is.eof())
+    {
+        values.push_back(start);
+        return true;
+    }
+    if (!(is >> c1 >> stop >> c2 >> count) || c1 != ':' || c2 != ':' || count < 1
+        || !(is >> std::ws).eof())
+        return false;
+    for (int i = 0; i < count; ++i)
+        values.push_back(count == 1 ? start : start + (stop - start)*i/(count - 1));
+    return true;
+}
+
+/// Add or replace an axis.
+/// @return False if the name or values are not valid.
+bool add_axis(std::vector<Axis>& axes, std::string const& name, std::string const& spec)
+{
+    Launch check;
+    Axis axis{name, {}};
+    if (!check.set(name, 0.0) || !parse_values(spec, axis.values))
+    {
+        std::cerr << "loft-sweep: bad parameter: " << name << ' ' << spec << std::endl;
+        return false;
+    }
+    for (auto& a : axes)
+        if (a.name == name)
+        {
+            a = axis;
+            return true;
+        }
+    axes.push_back(axis);
+    return true;
+}
+
+bool read_template(std::string const& file, std::vector<Axis>& axes)
+{
+    std::ifstream is(file);
+    if (!is)
+    {
+        std::cerr << "loft-sweep: can't read " << file << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(is, line))
+    {
+        std::istringstream ls(line);
+        std::string name, spec;
+        if (!(ls >> name) || name[0] == '#')
+            continue;
+        ls >> spec;
+        if (!add_axis(axes, name, spec))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads{0};
+    double duration{600.0};
+    double step{0.1};
+    std::string output;
+    std::vector<Axis> axes;
+
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (std::size_t i = 0; i < args.size(); ++i)
+    {
+        auto const& arg{args[i]};
+        auto has_value{i + 1 < args.size()};
+        try
+        {
+            if (arg == "-j" && has_value)
+                threads = std::stoul(args[++i]);
+            else if (arg == "-d" && has_value)
+                duration = std::stod(args[++i]);
+            else if (arg == "-s" && has_value)
+                step = std::stod(args[++i]);
+            else if (arg == "-o" && has_value)
+                output = args[++i];
+            else if (arg[0] == '-')
+            {
+                usage();
+                return 1;
+            }
+            else if (auto eq{arg.find('=')}; eq != std::string::npos)
+            {
+                if (!add_axis(axes, arg.substr(0, eq), arg.substr(eq + 1)))
+                    return 1;
+            }
+            else if (!read_template(arg, axes))
+                return 1;
+        }
+        catch (std::exception const&)
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (step <= 0.0)
+    {
+        usage();
+        return 1;
+    }
+
+    // Expand the cartesian product of the axes.  The last axis varies fastest.
+    std::vector<Launch> cases(1);
+    for (auto const& axis : axes)
+    {
+        std::vector<Launch> expanded;
+        for (auto const& c : cases)
+            for (auto v : axis.values)
+            {
+                expanded.push_back(c);
+                expanded.back().set(axis.name, v);
+            }
+        cases = std::move(expanded);
+    }
+
+    Ensemble ensemble(cases.size(), [&cases](std::size_t i) { return cases[i].build(); });
+    ensemble.run(duration, step, {}, threads);
+
+    std::ofstream file;
+    if (!output.empty())
+    {
+        file.open(output);
+        if (!file)
+        {
+            std::cerr << "loft-sweep: can't write " << output << std::endl;
+            return 1;
+        }
+    }
+    auto& os{output.empty() ? std::cout : file};
+    os << '#';
+    for (auto const& axis : axes)
+        os << ' ' << axis.name;
+    os << " impact time a e i periapsis apoapsis lat lon\n";
+    os << std::setprecision(9);
+    for (std::size_t i = 0; i < cases.size(); ++i)
+    {
+        auto out{ensemble.outcome(i)};
+        for (auto const& axis : axes)
+            os << cases[i].get(axis.name) << ' ';
+        os << out.impact << ' ' << out.time << ' '
+           << out.orbit.a << ' ' << out.orbit.e << ' ' << out.orbit.i << ' '
+           << out.orbit.periapsis << ' ' << out.orbit.apoapsis << ' '
+           << out.lat << ' ' << out.lon << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "atmosphere.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+// The table has fine samples where density changes quickly with altitude and coarse ones
+// above.
+static constexpr double fine_spacing{100.0}; ///< m
+static constexpr double fine_top{120e3}; ///< m
+static constexpr double coarse_spacing{1e3}; ///< m
+static constexpr double top_altitude{1000e3}; ///< m
+static constexpr std::size_t fine_samples{
+    static_cast<std::size_t>(fine_top/fine_spacing)};
+
+/// Specific gas constant for air: J/kg·K
+static constexpr double R_air{287.053};
+/// The earth's radius for converting to geopotential altitude: km
+static constexpr double r0{6356.766};
+
+/// A layer of the 1976 standard below 86 km.  Altitudes are geopotential.
+struct Layer
+{
+    double base; ///< km
+    double lapse; ///< K/km
+    double temperature; ///< K
+    double pressure; ///< Pa
+};
+
+static constexpr std::array<Layer, 7> layers{{
+    {0.0, -6.5, 288.15, 101325.0},
+    {11.0, 0.0, 216.65, 22632.06},
+    {20.0, 1.0, 216.65, 5474.889},
+    {32.0, 2.8, 228.65, 868.0187},
+    {47.0, 0.0, 270.65, 110.9063},
+    {51.0, -2.8, 270.65, 66.93887},
+    {71.0, -2.0, 214.65, 3.956420},
+}};
+
+/// The top of the layered part of the standard: km
+static constexpr double layer_top{86.0};
+
+/// An exponential fit to density above the layers.
+struct Shell
+{
+    double base; ///< km
+    double density; ///< kg/m³
+    double scale_height; ///< km
+};
+
+static constexpr std::array<Shell, 20> shells{{
+    {80.0, 1.905e-5, 5.799},
+    {90.0, 3.396e-6, 5.382},
+    {100.0, 5.297e-7, 5.877},
+    {110.0, 9.661e-8, 7.263},
+    {120.0, 2.438e-8, 9.473},
+    {130.0, 8.484e-9, 12.636},
+    {140.0, 3.845e-9, 16.149},
+    {150.0, 2.070e-9, 22.523},
+    {180.0, 5.464e-10, 29.740},
+    {200.0, 2.789e-10, 37.105},
+    {250.0, 7.248e-11, 45.546},
+    {300.0, 2.418e-11, 53.628},
+    {350.0, 9.518e-12, 53.298},
+    {400.0, 3.725e-12, 58.515},
+    {450.0, 1.585e-12, 60.828},
+    {500.0, 6.967e-13, 63.822},
+    {600.0, 1.454e-13, 71.835},
+    {700.0, 3.614e-14, 88.667},
+    {800.0, 1.170e-14, 124.64},
+    {900.0, 5.245e-15, 181.05},
+}};
+
+/// @return Temperature and density at a geometric altitude in km from the layers.
+static std::pair<double, double> layered(double z)
+{
+    // Convert to geopotential altitude.
+    auto h{r0*z/(r0 + z)};
+    auto above{[](double h, Layer const& l) { return h < l.base; }};
+    auto it{std::prev(std::upper_bound(layers.begin(), layers.end(), h, above))};
+    // g₀M/R*: K/km
+    double const g_M_R{34.1632};
+    auto T{it->temperature + it->lapse*(h - it->base)};
+    auto p{it->lapse == 0.0
+        ? it->pressure*std::exp(-g_M_R*(h - it->base)/it->temperature)
+        : it->pressure*std::pow(it->temperature/T, g_M_R/it->lapse)};
+    return {T, p/(R_air*T)};
+}
+
+/// @return The standard's kinetic temperature at a geometric altitude in km above the
+/// layers: K.  It's constant to 91 km, follows an ellipse to 110 km, rises linearly to
+/// 120 km, and then approaches 1000 K exponentially.
+static double thermosphere(double z)
+{
+    if (z < 91.0)
+        return 186.8673;
+    if (z < 110.0)
+    {
+        auto x{(z - 91.0)/19.9429};
+        return 263.1905 - 76.3232*std::sqrt(1.0 - x*x);
+    }
+    if (z < 120.0)
+        return 240.0 + 12.0*(z - 110.0);
+    auto xi{(z - 120.0)*(r0 + 120.0)/(r0 + z)};
+    return 1000.0 - 640.0*std::exp(-0.01875*xi);
+}
+
+/// @return Density at a geometric altitude in km from the exponential fit.
+static double exponential(double z)
+{
+    auto above{[](double z, Shell const& s) { return z < s.base; }};
+    auto it{std::prev(std::upper_bound(shells.begin(), shells.end(), z, above))};
+    return it->density*std::exp(-(z - it->base)/it->scale_height);
+}
+
+Atmosphere::Atmosphere()
+{
+    auto const n{fine_samples + static_cast<std::size_t>((top_altitude - fine_top)
+                                                         /coarse_spacing) + 1};
+    m_samples.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto z{i <= fine_samples
+            ? i*fine_spacing/1e3
+            : (fine_top + (i - fine_samples)*coarse_spacing)/1e3};
+        auto [T, rho] = z < layer_top ? layered(z) : std::pair{thermosphere(z),
+                                                               exponential(z)};
+        m_samples.push_back({static_cast<float>(rho), static_cast<float>(T)});
+    }
+}
+
+std::shared_ptr<Atmosphere const> Atmosphere::standard()
+{
+    static std::shared_ptr<Atmosphere const> const atmosphere{new Atmosphere};
+    return atmosphere;
+}
+
+bool Atmosphere::locate(double altitude, std::size_t& index, double& fraction) const
+{
+    if (altitude >= top_altitude)
+        return false;
+    altitude = std::max(altitude, 0.0);
+    auto x{altitude < fine_top
+        ? altitude/fine_spacing
+        : fine_samples + (altitude - fine_top)/coarse_spacing};
+    index = static_cast<std::size_t>(x);
+    fraction = x - index;
+    return true;
+}
+
+double Atmosphere::density(double altitude) const
+{
+    std::size_t i;
+    double f;
+    if (!locate(altitude, i, f))
+        return 0.0;
+    return m_samples[i].density + f*(m_samples[i + 1].density - m_samples[i].density);
+}
+
+double Atmosphere::temperature(double altitude) const
+{
+    std::size_t i;
+    double f;
+    if (!locate(altitude, i, f))
+        return m_samples.back().temperature;
+    return m_samples[i].temperature
+        + f*(m_samples[i + 1].temperature - m_samples[i].temperature);
+}
+
+double Atmosphere::pressure(double altitude) const
+{
+    if (altitude >= layer_top*1e3)
+        return std::numeric_limits<double>::quiet_NaN();
+    return density(altitude)*R_air*temperature(altitude);
+}
+
+double Atmosphere::top() const
+{
+    return top_altitude;
+}
@@ -0,0 +1,62 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_ATMOSPHERE_HH_INCLUDED
+#define LOFT_LOFTLIB_ATMOSPHERE_HH_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/// Air density and temperature as functions of altitude, looked up in a table that's
+/// computed once.  Values between samples are interpolated linearly, so a lookup costs
+/// a multiply and a few loads instead of exponentials and powers.
+class Atmosphere
+{
+public:
+    /// @return The US Standard Atmosphere, 1976, shared by all worlds that use it.  Below
+    /// 86 km the table follows the standard's layers.  From 86 km to 1000 km, density
+    /// follows an exponential fit to the standard, and temperature follows the standard's
+    /// kinetic temperature up to about 1000 K.  There's no air above 1000 km.
+    static std::shared_ptr<Atmosphere const> standard();
+
+    /// @return Air density at a geometric altitude: kg/m³
+    double density(double altitude) const;
+    /// @return Air temperature at a geometric altitude: K
+    double temperature(double altitude) const;
+    /// @return Air pressure at a geometric altitude from the ideal gas law: Pa.  NaN at
+    /// 86 km and above, where the air's molar mass falls and the law with the sea-level
+    /// gas constant doesn't hold.
+    double pressure(double altitude) const;
+    /// @return The altitude above which there's no air: m
+    double top() const;
+
+private:
+    Atmosphere();
+
+    /// One table entry.  Single precision keeps the whole table in a few pages.
+    struct Sample
+    {
+        float density;
+        float temperature;
+    };
+    /// Find the sample below an altitude and the fraction of the way to the next one.
+    /// @return False if the altitude is above the top of the table.
+    bool locate(double altitude, std::size_t& index, double& fraction) const;
+
+    std::vector<Sample> m_samples;
+};
+
+#endif // LOFT_LOFTLIB_ATMOSPHERE_HH_INCLUDED
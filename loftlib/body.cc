@@ -14,11 +14,23 @@
 //  If not, see <http://www.gnu.org/licenses/>.
 
 #include "body.hh"
+#include "serialize.hh"
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <numeric>
 
+/// Add to a sum with Kahan's compensation.
+/// @param error The rounding error of the previous additions.  Updated.
+static void compensated_add(V3& sum, V3& error, V3 const& increment)
+{
+    auto y{increment - error};
+    auto t{sum + y};
+    error = (t - sum) - y;
+    sum = t;
+}
+
 Body::Body(double mass, M3 const& inertia,
            const V3 r, const V3 v, M3 const& orientation, const V3 omega)
     : m_mass(mass),
@@ -41,6 +53,9 @@ void Body::capture(Body_ptr part)
     part->m_orientation = tr(m_orientation)*part->m_orientation;
     part->m_v_cm = V0;
     part->m_omega = V0;
+    part->clear_compensation();
+    part->invalidate(true);
+    part->invalidate_parts();
 }
 
 void Body::release(Body_ptr part)
@@ -53,12 +68,17 @@ void Body::release(Body_ptr part)
     auto cm{r_cm()};
     part->m_parent = nullptr;
     m_subs.erase(it);
+    invalidate(true);
 
     part->m_r = transform_out(part->m_r);
     part->m_orientation = m_orientation*part->m_orientation;
     part->m_v_cm = m_v_cm + cross(m_omega, part->m_r - cm);
     m_v_cm += cross(m_omega, m_r - cm);
     part->m_omega = m_omega;
+    part->clear_compensation();
+    clear_compensation();
+    part->invalidate(false);
+    part->invalidate_parts();
 }
 
 void Body::add_momentum(Body_ptr const part)
@@ -83,6 +103,7 @@ void Body::add_momentum(Body_ptr const part)
     auto part_m{part->m()};
     auto v_cm{m_v_cm};
     m_v_cm = (head_m*v_cm + part_m*part->v_cm())/(head_m + part_m);
+    clear_compensation();
 
     auto new_cm{(head_m*r_cm() + part_m*part->r_cm())/(head_m + part_m)};
     auto r_head{r_cm() - new_cm};
@@ -125,29 +146,83 @@ bool Body::is_free() const
     return !m_parent;
 }
 
+bool Body::is_scripted() const
+{
+    return false;
+}
+
 bool Body::intersects(Body const&) const
 {
     return false;
 }
 
+void Body::invalidate(bool mass)
+{
+    for (auto* b{this}; b; b = b->m_parent)
+    {
+        if (mass)
+            b->m_total = -1.0;
+        b->m_cm_valid = false;
+        b->m_I_valid = false;
+    }
+}
+
+void Body::invalidate_parts()
+{
+    for (auto const& b : m_subs)
+    {
+        b->m_I_valid = false;
+        b->invalidate_parts();
+    }
+}
+
+void Body::moved()
+{
+    if (m_parent)
+        m_parent->invalidate(false);
+}
+
 double Body::m() const
 {
-    return std::accumulate(m_subs.begin(), m_subs.end(), m_mass,
-                           [](double m, Body_ptr b){ return m + b->m(); });
+    if (m_total < 0.0)
+        m_total = std::accumulate(m_subs.begin(), m_subs.end(), m_mass,
+                                  [](double m, Body_ptr b){ return m + b->m(); });
+    return m_total;
 }
 
 M3 Body::I()
 {
-    return I(m_parent ? m_parent->transform_out(r_cm()) : r_cm());
+    if (!m_I_valid)
+    {
+        // Add the parts' inertias about their own centers of mass with the parallel axis
+        // theorem.
+        auto cm{absolute(r_cm())};
+        auto r{absolute(m_r) - cm};
+        m_I = m_inertia + m_mass*(square(r)*M1 - outer(r, r));
+        for (auto const& b : m_subs)
+        {
+            auto d{transform_out(b->r_cm()) - cm};
+            m_I += b->I() + b->m()*(square(d)*M1 - outer(d, d));
+        }
+        m_I_valid = true;
+    }
+    return m_I;
 }
 
 M3 Body::I(V3 const& center)
 {
-    V3 r{(m_parent ? m_parent->transform_out(m_r) : m_r) - center};
-    return std::accumulate(m_subs.begin(), m_subs.end(),
-                           m_inertia + m_mass*(square(r)*M1 - outer(r, r)),
-                           [center](M3 const& i, const Body_ptr b){
-                               return i + b->I(center); });
+    auto r{absolute(r_cm()) - center};
+    return I() + m()*(square(r)*M1 - outer(r, r));
+}
+
+V3 Body::absolute(V3 const& r) const
+{
+    return m_parent ? m_parent->transform_out(r) : r;
+}
+
+std::list<Body::Body_ptr> const& Body::parts() const
+{
+    return m_subs;
 }
 
 V3 Body::r() const
@@ -158,13 +233,19 @@ V3 Body::r() const
 V3 Body::r_cm() const
 {
     // Head position is added after dividing by total mass.
-    auto total{m()};
-    if (total < 1e-9)
-        return m_r;
-    return m_r + std::accumulate(m_subs.begin(), m_subs.end(), V0,
-                                 [this](V3 const& rm, Body_ptr b){
-                                     return rm + rotate_out(b->r_cm())*b->m(); })
-        /total;
+    if (!m_cm_valid)
+    {
+        auto total{m()};
+        // Sub-body positions are in this body's frame.  Rotate them to the enclosing
+        // frame.
+        m_cm_offset = total < 1e-9
+            ? V0
+            : std::accumulate(m_subs.begin(), m_subs.end(), V0,
+                              [this](V3 const& rm, Body_ptr b){
+                                  return rm + m_orientation*b->r_cm()*b->m(); })/total;
+        m_cm_valid = true;
+    }
+    return m_r + m_cm_offset;
 }
 
 V3 Body::v_cm() const
@@ -184,7 +265,10 @@ V3 const& Body::omega() const
 
 void Body::impulse(V3 const& imp)
 {
-    m_v_cm += imp/m();
+    if (m_compensated)
+        compensated_add(m_v_cm, m_v_error, imp/m());
+    else
+        m_v_cm += imp/m();
 }
 
 void Body::impulse(V3 const& imp, V3 const& r)
@@ -195,13 +279,46 @@ void Body::impulse(V3 const& imp, V3 const& r)
 
 void Body::step(double time)
 {
+    // A body that doesn't rotate keeps its orientation and the offset of its center of
+    // mass, so only the captors' totals go out of date when it moves.  A part at rest in
+    // its captor's frame doesn't change anything.
+    if (m_omega == V0)
+    {
+        if (m_v_cm != V0)
+        {
+            if (m_compensated)
+                compensated_add(m_r, m_r_error, m_v_cm*time);
+            else
+                m_r += m_v_cm*time;
+            moved();
+        }
+        for (auto b : m_subs)
+            b->step(time);
+        return;
+    }
+
     // The origin of the body, m_r, is generally not at the CM.  Find the new origin after
     // rotation by transforming CM - m_r into the body's frame before rotating the body,
     // and then transforming back out of the body's frame.
+    // Bring m_cm_offset up to date.
     auto cm{r_cm()};
-    auto dr{rotate_in(cm - m_r)};
-    m_orientation = rot(m_orientation, rotate_in(m_omega)*time);
-    m_r = cm + m_v_cm*time - rotate_out(dr);
+    if (m_compensated)
+    {
+        // Add the change to m_r instead of recalculating it from the CM.  The offset
+        // from m_r to the CM is known without the rounding of cm - m_r.
+        auto offset{m_cm_offset};
+        auto dr{rotate_in(offset)};
+        m_orientation = rot(m_orientation, rotate_in(m_omega)*time);
+        compensated_add(m_r, m_r_error, m_v_cm*time + (offset - rotate_out(dr)));
+    }
+    else
+    {
+        auto dr{rotate_in(cm - m_r)};
+        m_orientation = rot(m_orientation, rotate_in(m_omega)*time);
+        m_r = cm + m_v_cm*time - rotate_out(dr);
+    }
+    invalidate(false);
+    invalidate_parts();
     for (auto b : m_subs)
         b->step(time);
 }
@@ -209,19 +326,102 @@ void Body::step(double time)
 void Body::set_r(V3 const& r)
 {
     m_r = r;
+    m_r_error = V0;
+    moved();
+}
+
+void Body::displace(V3 const& offset)
+{
+    if (!m_compensated)
+        return set_r(m_r + offset);
+    compensated_add(m_r, m_r_error, offset);
+    moved();
+}
+
+void Body::rebase(V3 const& offset)
+{
+    displace(-offset);
+}
+
+void Body::set_v(V3 const& v)
+{
+    m_v_cm = v;
+    m_v_error = V0;
 }
 
 void Body::set_orientation(M3 const& o)
 {
     m_orientation = o;
+    invalidate(false);
+    invalidate_parts();
 }
 
 void Body::set_mass(double m)
 {
     m_mass = m;
+    invalidate(true);
 }
 
 void Body::set_inertia(M3 const& i)
 {
     m_inertia = i;
+    invalidate(false);
+}
+
+void Body::set_drag_area(double area)
+{
+    m_drag_area = area;
+}
+
+double Body::drag_area() const
+{
+    return m_drag_area;
+}
+
+void Body::set_compensated(bool compensated)
+{
+    m_compensated = compensated;
+    clear_compensation();
+}
+
+bool Body::is_compensated() const
+{
+    return m_compensated;
+}
+
+void Body::clear_compensation()
+{
+    m_r_error = V0;
+    m_v_error = V0;
+}
+
+void Body::save(std::ostream& os) const
+{
+    serialize::write(os, m_mass);
+    serialize::write(os, m_inertia);
+    serialize::write(os, m_r);
+    serialize::write(os, m_v_cm);
+    serialize::write(os, m_orientation);
+    serialize::write(os, m_omega);
+    serialize::write(os, m_drag_area);
+    serialize::write(os, static_cast<std::uint8_t>(m_compensated));
+    serialize::write(os, m_r_error);
+    serialize::write(os, m_v_error);
+}
+
+void Body::restore(std::istream& is)
+{
+    serialize::read(is, m_mass);
+    serialize::read(is, m_inertia);
+    serialize::read(is, m_r);
+    serialize::read(is, m_v_cm);
+    serialize::read(is, m_orientation);
+    serialize::read(is, m_omega);
+    serialize::read(is, m_drag_area);
+    std::uint8_t compensated{0};
+    serialize::read(is, compensated);
+    m_compensated = compensated != 0;
+    serialize::read(is, m_r_error);
+    serialize::read(is, m_v_error);
+    invalidate(true);
 }
@@ -18,6 +18,7 @@
 
 #include "three-vector.hh"
 
+#include <iosfwd>
 #include <list>
 #include <memory>
 
@@ -43,11 +44,13 @@ public:
     void release(Body_ptr part);
 
     // * Physical properties calculated from this body and its sub-bodies.
-    /// @return Total mass
+    // The totals are cached.  A change to a body marks its captors' totals out of date,
+    // and they're recalculated when next asked for.
+    /// @return Total mass.
     double m() const;
     /// @return Total rotational inertia about the center of mass.
     M3 I();
-    /// @return Position of the center of mass.
+    /// @return Position of the center of mass in the enclosing frame.
     V3 r_cm() const;
     /// @return Velocity of the center of mass.
     V3 v_cm() const;
@@ -83,6 +86,8 @@ public:
 
     /// @return True if this body is not captured by another body.
     bool is_free() const;
+    /// @return True if the body's path is given in advance rather than integrated.
+    virtual bool is_scripted() const;
     /// @return True if this body occupies some of the same space as another.
     virtual bool intersects(const Body& b) const;
 
@@ -90,12 +95,36 @@ public:
     //change, e.g. fuel is consumed.
     /// Set the body's position.
     void set_r(const V3& r);
+    /// Move the body without changing its velocity.
+    void displace(const V3& offset);
+    /// Called on free bodies when the universe moves the origin of its coordinates.
+    /// @param offset The new origin in the old coordinates.
+    virtual void rebase(const V3& offset);
+    /// Set the velocity of the body's center of mass.
+    void set_v(const V3& v);
     /// Set the body's orientation.
     void set_orientation(const M3& o);
     /// Set the body's mass.
     void set_mass(double mass);
     /// Set the body's inertia tensor.
     void set_inertia(const M3& i);
+    /// Set the drag coefficient times the cross-sectional area.  Bodies with a drag area
+    /// slow down in the atmospheres of worlds.
+    void set_drag_area(double area);
+    /// @return The drag coefficient times the cross-sectional area: m²
+    double drag_area() const;
+    /// Choose compensated (Kahan) summation for the body's position and velocity.  The
+    /// rounding error of each addition is carried into the next one, so the sums over
+    /// many steps stay accurate to about one rounding however small the increments.
+    /// It's off by default, since it adds work to every step and impulse.
+    void set_compensated(bool compensated);
+    bool is_compensated() const;
+
+    // * Checkpoints.  Sub-bodies are saved by the checkpoint, not by the body.
+    /// Write the body's properties and state to a binary stream.
+    virtual void save(std::ostream& os) const;
+    /// Read the properties and state written by save().
+    virtual void restore(std::istream& is);
 
 protected:
     // * Physical properties
@@ -103,18 +132,51 @@ protected:
     double m_mass;
     /// This body's rotational inertia, not including sub-bodies.
     M3 m_inertia;
+    /// Drag coefficient times cross-sectional area.  Zero for no drag.
+    double m_drag_area = 0.0;
+
+    /// @return The bodies captured by this one in the order they were captured.
+    std::list<Body_ptr> const& parts() const;
 
 private:
-    /// @return Total rotational inertia about a point.
+    friend class Checkpoint;
+
+    /// @return Total rotational inertia about a point in the absolute frame.
     M3 I(const V3& center);
+    /// @return A point in the enclosing frame transformed to the absolute frame.
+    V3 absolute(V3 const& r) const;
     /// Take care of conservation of linear and angular momentum when a body is added.
     void add_momentum(const Body_ptr part);
+    /// Forget the rounding errors carried by compensated summation.  Call when the
+    /// position and velocity are set rather than accumulated.
+    void clear_compensation();
+    /// Mark the cached totals of this body and the bodies that enclose it out of date.
+    /// @param mass True if the mass changed, false if only the position, orientation or
+    /// inertia did.
+    void invalidate(bool mass);
+    /// Mark the inertias of the sub-bodies out of date.  Call when this body turns, since
+    /// they're kept in the absolute frame.
+    void invalidate_parts();
+    /// Mark the captors' totals out of date when this body moves without turning.  Its
+    /// own center of mass offset and inertia don't change.
+    void moved();
 
     /// The body that has this body as one of its sub-bodies, or nullptr if this is the
     /// top-level body.
     Body* m_parent = nullptr;
     /// The sub-bodies of this body.
     std::list<Body_ptr> m_subs;
+    // * Cached totals
+    /// The mass of this body and its sub-bodies, or negative if it needs to be
+    /// recalculated.
+    mutable double m_total = -1.0;
+    /// The center of mass relative to m_r in the enclosing frame.
+    mutable V3 m_cm_offset;
+    mutable bool m_cm_valid = false;
+    /// The rotational inertia about the center of mass in the absolute frame.  A captor's
+    /// inertia is the sum of its parts' cached inertias moved to its center of mass.
+    M3 m_I;
+    bool m_I_valid = false;
 
     // * State
     /// Position relative to the enclosing frame.
@@ -128,6 +190,12 @@ private:
     M3 m_orientation;
     /// The angular velocity vector of this body in the enclosing frame.
     V3 m_omega;
+    // * Compensated summation
+    bool m_compensated = false;
+    /// The parts of m_r and m_v_cm lost to rounding, to be subtracted from the next
+    /// increments.
+    V3 m_r_error = V0;
+    V3 m_v_error = V0;
 };
 
 #endif // LOFT_LOFTLIB_BODY_HH_INCLUDED
@@ -0,0 +1,229 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "body.hh"
+#include "checkpoint.hh"
+#include "rocket.hh"
+#include "serialize.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include <array>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Layout:
+//   magic, version, collision flag, time, number of bodies
+//   for each body in the universe's order: kind, properties and state from Body::save()
+//   for each body: the number of bodies it has captured, their indices in capture order
+//   origin, index of the floating origin's anchor or the number of bodies if none,
+//   rebase distance, gravity precision, summation, time error, diagnostics flag
+
+/// Identifies a checkpoint file.
+static constexpr std::array<char, 8> magic{'L', 'o', 'f', 't', 'C', 'k', 'p', 't'};
+
+namespace
+{
+/// The types of bodies that can be restored.
+enum class Kind : std::uint32_t
+{
+    body,
+    world,
+    rocket,
+};
+
+Kind kind(Body const& body)
+{
+    if (dynamic_cast<Rocket const*>(&body))
+        return Kind::rocket;
+    if (dynamic_cast<World const*>(&body))
+        return Kind::world;
+    return Kind::body;
+}
+
+/// @return A body of the given kind ready to have its state restored.
+std::shared_ptr<Body> make_body(Kind kind)
+{
+    switch (kind)
+    {
+    case Kind::body:
+        return std::make_shared<Body>(0.0, M0, V0, V0, M1, V0);
+    case Kind::world:
+        return std::make_shared<World>(0.0, 0.0, V0, V0, M1, 1.0);
+    case Kind::rocket:
+        return std::make_shared<Rocket>(1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, V0, M1);
+    }
+    return nullptr;
+}
+
+/// Read-only stream buffer over a block of memory.
+class Memory_Buffer : public std::streambuf
+{
+public:
+    Memory_Buffer(char const* data, std::size_t size)
+    {
+        auto* begin{const_cast<char*>(data)};
+        setg(begin, begin, begin + size);
+    }
+};
+}
+
+bool Checkpoint::save(Universe const& universe, std::ostream& os)
+{
+    auto const& bodies{universe.m_body};
+    std::map<Body const*, std::uint64_t> index;
+    for (auto const& b : bodies)
+        index.emplace(b.get(), index.size());
+
+    os.write(magic.data(), magic.size());
+    serialize::write(os, version);
+    serialize::write(os, static_cast<std::uint32_t>(universe.m_handle_collision));
+    serialize::write(os, universe.m_time);
+    serialize::write(os, static_cast<std::uint64_t>(bodies.size()));
+    for (auto const& b : bodies)
+    {
+        serialize::write(os, kind(*b));
+        b->save(os);
+    }
+    // Parts that aren't in the universe, such as a rocket's engine, are saved by their
+    // owners.
+    for (auto const& b : bodies)
+    {
+        std::vector<std::uint64_t> parts;
+        for (auto const& part : b->m_subs)
+            if (auto it{index.find(part.get())}; it != index.end())
+                parts.push_back(it->second);
+        serialize::write(os, static_cast<std::uint64_t>(parts.size()));
+        for (auto i : parts)
+            serialize::write(os, i);
+    }
+    serialize::write(os, universe.m_origin);
+    auto anchor{index.find(universe.m_anchor.get())};
+    serialize::write(os, anchor == index.end() ? static_cast<std::uint64_t>(bodies.size())
+          : anchor->second);
+    serialize::write(os, universe.m_rebase_distance);
+    serialize::write(os, static_cast<std::uint32_t>(universe.m_precision));
+    serialize::write(os, static_cast<std::uint32_t>(universe.m_summation));
+    serialize::write(os, universe.m_time_error);
+    serialize::write(os, static_cast<std::uint8_t>(universe.m_diagnose));
+    return static_cast<bool>(os);
+}
+
+bool Checkpoint::save(Universe const& universe, std::string const& path)
+{
+    std::ofstream os(path, std::ios::binary);
+    return os && save(universe, os) && os.flush();
+}
+
+std::shared_ptr<Universe> Checkpoint::load(std::istream& is)
+{
+    std::array<char, 8> file_magic{};
+    std::uint32_t file_version{0};
+    std::uint32_t collision{0};
+    double time{0.0};
+    std::uint64_t n{0};
+    is.read(file_magic.data(), file_magic.size());
+    serialize::read(is, file_version);
+    serialize::read(is, collision);
+    serialize::read(is, time);
+    serialize::read(is, n);
+    if (!is || file_magic != magic || file_version != version)
+        return nullptr;
+
+    auto universe{std::make_shared<Universe>(collision != 0)};
+    universe->m_time = time;
+    std::vector<std::shared_ptr<Body>> bodies;
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        auto k{Kind::body};
+        serialize::read(is, k);
+        auto body{is ? make_body(k) : nullptr};
+        if (!body)
+            return nullptr;
+        // Add before restoring so that the body's summation flag isn't overwritten.
+        universe->add(body);
+        body->restore(is);
+        bodies.push_back(body);
+    }
+    for (auto& b : bodies)
+    {
+        std::uint64_t count{0};
+        serialize::read(is, count);
+        for (std::uint64_t j = 0; is && j < count; ++j)
+        {
+            std::uint64_t i{n};
+            serialize::read(is, i);
+            if (i >= n || bodies[i]->m_parent)
+                return nullptr;
+            // The part's state is already relative to the captor's frame.
+            b->m_subs.push_back(bodies[i]);
+            bodies[i]->m_parent = b.get();
+            b->invalidate(true);
+        }
+    }
+    std::uint64_t anchor{n};
+    serialize::read(is, universe->m_origin);
+    serialize::read(is, anchor);
+    serialize::read(is, universe->m_rebase_distance);
+    std::uint32_t precision{0};
+    serialize::read(is, precision);
+    if (precision > static_cast<std::uint32_t>(Universe::Precision::mixed))
+        return nullptr;
+    universe->m_precision = static_cast<Universe::Precision>(precision);
+    std::uint32_t summation{0};
+    serialize::read(is, summation);
+    serialize::read(is, universe->m_time_error);
+    if (summation > static_cast<std::uint32_t>(Universe::Summation::compensated))
+        return nullptr;
+    // Set the policy directly.  The bodies have their own flags and errors.
+    universe->m_summation = static_cast<Universe::Summation>(summation);
+    // Monitoring starts over.
+    std::uint8_t diagnose{0};
+    serialize::read(is, diagnose);
+    universe->set_diagnostics(diagnose != 0);
+    if (anchor < n)
+        universe->m_anchor = bodies[anchor];
+    return is ? universe : nullptr;
+}
+
+std::shared_ptr<Universe> Checkpoint::load(std::string const& path)
+{
+    auto fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return nullptr;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    auto size{static_cast<std::size_t>(st.st_size)};
+    auto* data{::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    Memory_Buffer buffer(static_cast<char const*>(data), size);
+    std::istream is(&buffer);
+    auto universe{load(is)};
+    ::munmap(data, size);
+    return universe;
+}
@@ -0,0 +1,54 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_CHECKPOINT_HH_INCLUDED
+#define LOFT_LOFTLIB_CHECKPOINT_HH_INCLUDED
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+
+class Universe;
+
+/// Binary snapshots of the full state of a universe: every body's properties and state,
+/// which bodies have captured which, rocket fuel and engine settings, and the time.  A
+/// universe loaded from a checkpoint continues exactly as the saved one would have, so
+/// many what-if runs can be forked from one saved state.  Values are stored in the
+/// machine's native format, so checkpoints are not portable between architectures.
+/// Functions attached to the universe, such as scheduled events, are not saved.
+class Checkpoint
+{
+public:
+    /// The format version written by save().  Loading other versions fails.
+    static constexpr std::uint32_t version{9};
+
+    /// Write a checkpoint to a stream.
+    /// @return False if the stream could not be written.
+    static bool save(Universe const& universe, std::ostream& os);
+    /// Write a checkpoint to a file.
+    /// @return False if the file could not be written.
+    static bool save(Universe const& universe, std::string const& path);
+    /// Read a checkpoint from a stream.
+    /// @return The restored universe, or nullptr if the stream does not hold a valid
+    /// checkpoint.
+    static std::shared_ptr<Universe> load(std::istream& is);
+    /// Read a checkpoint from a file.  The file is memory-mapped and read in place.
+    /// @return The restored universe, or nullptr if the file could not be read or does not
+    /// hold a valid checkpoint.
+    static std::shared_ptr<Universe> load(std::string const& path);
+};
+
+#endif // LOFT_LOFTLIB_CHECKPOINT_HH_INCLUDED
@@ -0,0 +1,386 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "body.hh"
+#include "compressed-trajectory.hh"
+#include "universe.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// The start of a compressed trajectory file.
+struct Compressed_Header
+{
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t block;
+    std::uint64_t bodies;
+    double position;
+    double velocity;
+    double angle;
+    std::array<char, 16> unused;
+};
+static_assert(sizeof(Compressed_Header) == 64);
+
+/// The end of a compressed trajectory file.  The block index comes just before it.
+struct Compressed_Footer
+{
+    std::uint64_t blocks;
+    std::uint64_t frames;
+    std::array<char, 8> magic;
+};
+
+static constexpr std::array<char, 8> compressed_magic{'L', 'o', 'f', 't', 'T', 'r', 'j', 'Z'};
+static constexpr std::uint32_t compressed_version{1};
+
+/// Append a signed integer as a zigzag variable-length integer: 7 bits per byte, low bits
+/// first, with the high bit set on all but the last byte.
+static void put(std::string& buffer, std::int64_t value)
+{
+    auto u{(static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63)};
+    while (u >= 0x80)
+    {
+        buffer.push_back(static_cast<char>(u | 0x80));
+        u >>= 7;
+    }
+    buffer.push_back(static_cast<char>(u));
+}
+
+/// Read a value written by put().  Reading stops at the end of the data, so a truncated
+/// value decodes to its low bits.
+static std::int64_t get(char const* data, std::size_t& position, std::size_t end)
+{
+    std::uint64_t u{0};
+    for (int shift = 0; shift < 64 && position < end; shift += 7)
+    {
+        auto byte{static_cast<unsigned char>(data[position++])};
+        u |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            break;
+    }
+    return static_cast<std::int64_t>(u >> 1) ^ -static_cast<std::int64_t>(u & 1);
+}
+
+/// @return The tolerance for each element of a quantized state.
+static std::array<double, 9> tolerances(Quantization const& q)
+{
+    return {q.position, q.position, q.position,
+            q.velocity, q.velocity, q.velocity,
+            q.angle, q.angle, q.angle};
+}
+
+Trajectory_Predictor::Trajectory_Predictor(std::size_t bodies, Quantization const& q)
+    : m_ratio(q.velocity/q.position),
+      m_q1(bodies),
+      m_q2(bodies)
+{
+}
+
+void Trajectory_Predictor::reset()
+{
+    m_history = 0;
+}
+
+Quantized_State Trajectory_Predictor::predict(std::size_t i) const
+{
+    Quantized_State p{};
+    if (m_history == 0)
+        return p;
+    auto const& q1{m_q1[i]};
+    auto const& q2{m_q2[i]};
+    for (std::size_t k = 3; k < 9; ++k)
+        p[k] = m_history == 1 ? q1[k] : 2*q1[k] - q2[k];
+    return p;
+}
+
+void Trajectory_Predictor::predict_position(std::size_t i, Quantized_State& p,
+                                            Quantized_State const& q, double dt) const
+{
+    if (m_history == 0)
+        return;
+    auto const& q1{m_q1[i]};
+    for (std::size_t k = 0; k < 3; ++k)
+        p[k] = std::llround(q1[k] + 0.5*(q1[k+3] + q[k+3])*dt*m_ratio);
+}
+
+void Trajectory_Predictor::update(std::size_t i, Quantized_State const& q)
+{
+    m_q2[i] = m_q1[i];
+    m_q1[i] = q;
+}
+
+void Trajectory_Predictor::next_frame()
+{
+    ++m_history;
+}
+
+std::size_t Trajectory_Predictor::history() const
+{
+    return m_history;
+}
+
+Compressed_Trajectory_Writer::Compressed_Trajectory_Writer(std::string const& path,
+                                                           std::size_t bodies,
+                                                           Quantization const& quantization,
+                                                           std::size_t block,
+                                                           std::size_t every)
+    : Trajectory_Sink(every),
+      m_os(path, std::ios::binary | std::ios::trunc),
+      m_bodies(bodies),
+      m_quantization(quantization),
+      m_block(std::max<std::size_t>(1, block)),
+      m_predictor(bodies, quantization),
+      m_states(bodies)
+{
+    Compressed_Header header{compressed_magic, compressed_version,
+                             static_cast<std::uint32_t>(m_block), bodies,
+                             quantization.position, quantization.velocity, quantization.angle,
+                             {}};
+    m_os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+}
+
+Compressed_Trajectory_Writer::~Compressed_Trajectory_Writer()
+{
+    if (!m_os)
+        return;
+    flush();
+    for (auto const& block : m_index)
+        m_os.write(reinterpret_cast<char const*>(&block), sizeof(block));
+    Compressed_Footer footer{m_index.size(), m_frames, compressed_magic};
+    m_os.write(reinterpret_cast<char const*>(&footer), sizeof(footer));
+}
+
+bool Compressed_Trajectory_Writer::is_open() const
+{
+    return m_os.good();
+}
+
+void Compressed_Trajectory_Writer::record(Universe const& universe)
+{
+    assert(universe.bodies().size() == m_bodies);
+    if (m_frames % m_block == 0)
+    {
+        flush();
+        m_index.push_back({static_cast<std::uint64_t>(m_os.tellp()), m_frames,
+                           universe.time()});
+        m_predictor.reset();
+    }
+
+    auto time{universe.time()};
+    auto dt{time - m_last_time};
+    m_last_time = time;
+    m_buffer.append(reinterpret_cast<char const*>(&time), sizeof(time));
+
+    auto tol{tolerances(m_quantization)};
+    std::size_t i{0};
+    for (auto const& b : universe.bodies())
+    {
+        auto [r, v, a] = state(*b, universe.origin());
+        auto& q{m_states[i]};
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+            q[k] = std::llround(r[k]/tol[k]);
+            q[k+3] = std::llround(v[k]/tol[k+3]);
+            q[k+6] = std::llround(a[k]/tol[k+6]);
+        }
+        // Velocity and rotation go first so that position can be predicted from the
+        // current velocity.
+        auto p{m_predictor.predict(i)};
+        for (std::size_t k = 3; k < 9; ++k)
+            put(m_buffer, q[k] - p[k]);
+        m_predictor.predict_position(i, p, q, dt);
+        for (std::size_t k = 0; k < 3; ++k)
+            put(m_buffer, q[k] - p[k]);
+        m_predictor.update(i, q);
+        ++i;
+    }
+    m_predictor.next_frame();
+    ++m_frames;
+}
+
+std::size_t Compressed_Trajectory_Writer::frames() const
+{
+    return m_frames;
+}
+
+void Compressed_Trajectory_Writer::flush()
+{
+    m_os.write(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+}
+
+Compressed_Trajectory_Reader::Compressed_Trajectory_Reader(std::string const& path)
+{
+    auto fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return;
+    struct stat st;
+    auto size{::fstat(fd, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0};
+    auto* data{size >= sizeof(Compressed_Header) + sizeof(Compressed_Footer)
+               ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED};
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return;
+    m_data = static_cast<char const*>(data);
+    m_size = size;
+
+    Compressed_Header header;
+    std::memcpy(&header, m_data, sizeof(header));
+    Compressed_Footer footer;
+    std::memcpy(&footer, m_data + size - sizeof(footer), sizeof(footer));
+    // Check the block count before multiplying so the products can't overflow.
+    auto const entry_size{3*sizeof(std::uint64_t)};
+    if (header.magic != compressed_magic
+        || header.version != compressed_version
+        || footer.magic != compressed_magic
+        || header.block == 0
+        || header.bodies > size
+        || footer.blocks > (size - sizeof(header) - sizeof(footer))/entry_size
+        || footer.frames > footer.blocks*header.block)
+    {
+        ::munmap(const_cast<char*>(m_data), m_size);
+        m_data = nullptr;
+        return;
+    }
+
+    m_end = size - sizeof(footer) - footer.blocks*entry_size;
+    auto const* index{m_data + m_end};
+    for (std::size_t b = 0; b < footer.blocks; ++b)
+    {
+        std::uint64_t offset;
+        double time;
+        std::memcpy(&offset, index + entry_size*b, sizeof(offset));
+        std::memcpy(&time, index + entry_size*b + 2*sizeof(std::uint64_t), sizeof(time));
+        // Blocks are in order between the header and the index.
+        if (offset < (b == 0 ? sizeof(header) : m_offsets.back()) || offset >= m_end)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+            m_data = nullptr;
+            m_offsets.clear();
+            m_times.clear();
+            return;
+        }
+        m_offsets.push_back(offset);
+        m_times.push_back(time);
+    }
+
+    m_bodies = header.bodies;
+    m_frames = footer.frames;
+    m_block = header.block;
+    m_quantization = {header.position, header.velocity, header.angle};
+
+    m_predictor = Trajectory_Predictor(m_bodies, m_quantization);
+    m_position = sizeof(header);
+    m_id.resize(m_bodies);
+    for (std::size_t i = 0; i < m_bodies; ++i)
+        m_id[i] = i;
+    for (auto& column : m_columns)
+        column.resize(m_bodies);
+}
+
+Compressed_Trajectory_Reader::~Compressed_Trajectory_Reader()
+{
+    if (m_data)
+        ::munmap(const_cast<char*>(m_data), m_size);
+}
+
+bool Compressed_Trajectory_Reader::is_open() const
+{
+    return m_data;
+}
+
+std::size_t Compressed_Trajectory_Reader::bodies() const
+{
+    return m_bodies;
+}
+
+std::size_t Compressed_Trajectory_Reader::frames() const
+{
+    return m_frames;
+}
+
+Trajectory_Frame Compressed_Trajectory_Reader::frame(std::size_t index)
+{
+    assert(index < m_frames);
+    // Carry on from the read position if the frame is ahead of it in the same block.
+    // Otherwise start over at the frame's block.
+    auto block{index/m_block};
+    if (index + 1 != m_next && (index < m_next || block != m_next/m_block))
+    {
+        m_next = block*m_block;
+        m_position = m_offsets[block];
+    }
+    while (m_next <= index)
+        decode();
+
+    auto n{m_bodies};
+    auto const& c{m_columns};
+    return {m_time, {m_id.data(), n},
+            {c[0].data(), n}, {c[1].data(), n}, {c[2].data(), n},
+            {c[3].data(), n}, {c[4].data(), n}, {c[5].data(), n},
+            {c[6].data(), n}, {c[7].data(), n}, {c[8].data(), n}};
+}
+
+void Compressed_Trajectory_Reader::decode()
+{
+    // Blocks follow each other, so only the history needs to be reset.
+    if (m_next % m_block == 0)
+        m_predictor.reset();
+    // Corrupt data decodes as zeros rather than reading past the frames.
+    double time{0.0};
+    if (m_position + sizeof(time) <= m_end)
+        std::memcpy(&time, m_data + m_position, sizeof(time));
+    m_position = std::min(m_position + sizeof(time), m_end);
+    auto dt{time - m_time};
+    m_time = time;
+
+    auto tol{tolerances(m_quantization)};
+    Quantized_State q;
+    for (std::size_t i = 0; i < m_bodies; ++i)
+    {
+        auto p{m_predictor.predict(i)};
+        for (std::size_t k = 3; k < 9; ++k)
+            q[k] = p[k] + get(m_data, m_position, m_end);
+        m_predictor.predict_position(i, p, q, dt);
+        for (std::size_t k = 0; k < 3; ++k)
+            q[k] = p[k] + get(m_data, m_position, m_end);
+        m_predictor.update(i, q);
+        for (std::size_t k = 0; k < 9; ++k)
+            m_columns[k][i] = q[k]*tol[k];
+    }
+    m_predictor.next_frame();
+    ++m_next;
+}
+
+std::size_t Compressed_Trajectory_Reader::find(double time)
+{
+    // Find the block, then decode through it.
+    auto it{std::upper_bound(m_times.begin(), m_times.end(), time)};
+    if (it == m_times.begin())
+        return 0;
+    auto block{static_cast<std::size_t>(it - m_times.begin()) - 1};
+    auto index{block*m_block};
+    auto end{std::min(index + m_block, m_frames)};
+    while (index + 1 < end && frame(index + 1).time <= time)
+        ++index;
+    return index;
+}
@@ -0,0 +1,165 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_COMPRESSED_TRAJECTORY_HH_INCLUDED
+#define LOFT_LOFTLIB_COMPRESSED_TRAJECTORY_HH_INCLUDED
+
+#include "trajectory.hh"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// A compressed trajectory stores the same quantities as a trajectory file, rounded to a
+// fixed tolerance.  Each value is predicted from the body's previous states and only the
+// difference from the prediction is stored, as a variable-length integer.  Velocity and
+// rotation are extrapolated linearly from the previous two frames.  Position is advanced
+// from the previous position by the average of the previous and current velocities.  The
+// errors are bounded by half the tolerance and don't accumulate.
+//
+// Frames are grouped into blocks that start with the full quantized state, so reading
+// can start at any block.  An index of the blocks is written at the end of the file when
+// the writer is destroyed.
+
+/// Rounding tolerances for compressed trajectories.
+struct Quantization
+{
+    double position{1e-3}; ///< m
+    double velocity{1e-6}; ///< m/s
+    double angle{1e-9}; ///< rad
+};
+
+/// Quantized position, velocity and rotation vector of a body.
+using Quantized_State = std::array<std::int64_t, 9>;
+
+/// Predicts each body's quantized state from its history.  The writer and the reader run
+/// the same predictor, so only the residuals need to be stored.
+class Trajectory_Predictor
+{
+public:
+    Trajectory_Predictor(std::size_t bodies, Quantization const& quantization);
+
+    /// Forget the history at the start of a block.
+    void reset();
+    /// Predict velocity and rotation of a body for the next frame.
+    Quantized_State predict(std::size_t body) const;
+    /// Predict the position of a body once its velocity is known.
+    /// @param dt The time since the previous frame.
+    void predict_position(std::size_t body, Quantized_State& prediction,
+                          Quantized_State const& state, double dt) const;
+    /// Add a body's state to its history.
+    void update(std::size_t body, Quantized_State const& state);
+    /// Move on to the next frame.
+    void next_frame();
+    /// @return The number of frames since the last reset.
+    std::size_t history() const;
+
+private:
+    double m_ratio;
+    std::size_t m_history{0};
+    std::vector<Quantized_State> m_q1; ///< The previous frame.
+    std::vector<Quantized_State> m_q2; ///< The frame before that.
+};
+
+/// Writes compressed trajectory files.
+class Compressed_Trajectory_Writer : public Trajectory_Sink
+{
+public:
+    /// Create or replace a compressed trajectory file.
+    /// @param bodies The number of bodies in each frame.
+    /// @param block The number of frames between full states.
+    Compressed_Trajectory_Writer(std::string const& path, std::size_t bodies,
+                                 Quantization const& quantization = {},
+                                 std::size_t block = 64, std::size_t every = 1);
+    /// Write the last block and the index.
+    ~Compressed_Trajectory_Writer();
+
+    /// @return True if the file was created.
+    bool is_open() const;
+    void record(Universe const& universe) override;
+    /// @return The number of frames recorded.
+    std::size_t frames() const;
+
+private:
+    /// Write the pending block to the file.
+    void flush();
+
+    std::ofstream m_os;
+    std::size_t m_bodies;
+    Quantization m_quantization;
+    std::size_t m_block;
+    Trajectory_Predictor m_predictor;
+    std::size_t m_frames{0};
+    double m_last_time{0.0};
+    std::string m_buffer; ///< Encoded frames of the current block.
+    std::vector<Quantized_State> m_states;
+
+    struct Block
+    {
+        std::uint64_t offset;
+        std::uint64_t first;
+        double time;
+    };
+    std::vector<Block> m_index;
+};
+
+/// Random access to the frames of a compressed trajectory file.  Reading the next frame
+/// is cheap.  Other frames are found by decoding from the start of their block.
+class Compressed_Trajectory_Reader
+{
+public:
+    explicit Compressed_Trajectory_Reader(std::string const& path);
+    ~Compressed_Trajectory_Reader();
+    Compressed_Trajectory_Reader(Compressed_Trajectory_Reader const&) = delete;
+    Compressed_Trajectory_Reader& operator=(Compressed_Trajectory_Reader const&) = delete;
+
+    /// @return True if the file was mapped and is complete.
+    bool is_open() const;
+    /// @return The number of bodies in each frame.
+    std::size_t bodies() const;
+    /// @return The number of frames.
+    std::size_t frames() const;
+    /// @return The frame with the given index.  The columns are only valid until the next
+    /// call to frame().
+    Trajectory_Frame frame(std::size_t index);
+    /// @return The index of the last frame at or before the given time, or 0 if the time
+    /// is before the first frame.  Frames must be in time order.
+    std::size_t find(double time);
+
+private:
+    /// Decode the frame at the read position.
+    void decode();
+
+    char const* m_data{nullptr};
+    std::size_t m_size{0};
+    std::size_t m_end{0}; ///< The end of the frames and the start of the block index.
+    std::size_t m_bodies{0};
+    std::size_t m_frames{0};
+    std::size_t m_block{0};
+    Quantization m_quantization;
+    std::vector<std::uint64_t> m_offsets; ///< Where each block starts.
+    std::vector<double> m_times; ///< The first time in each block.
+
+    Trajectory_Predictor m_predictor{0, {}};
+    std::size_t m_next{0}; ///< The index of the frame at the read position.
+    std::size_t m_position{0}; ///< The read position in the file.
+    double m_time{0.0};
+    std::vector<std::uint64_t> m_id;
+    std::array<std::vector<double>, 9> m_columns;
+};
+
+#endif // LOFT_LOFTLIB_COMPRESSED_TRAJECTORY_HH_INCLUDED
@@ -0,0 +1,162 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ensemble.hh"
+#include "parallel.hh"
+#include "runner.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+
+namespace
+{
+/// Step a member until the end of the run or until its probe hits the world.
+Outcome propagate(Member& member, double duration, double step)
+{
+    auto& all{*member.universe};
+    auto& world{*member.world};
+    auto& probe{*member.probe};
+
+    // A probe that starts captured, e.g. a rocket on the pad, can't hit the world until
+    // it's released.
+    auto launched{probe.is_free()};
+    auto impact{false};
+    auto r{probe.r_cm()};
+    auto v{probe.v_cm()};
+    Runner runner(all, step);
+    runner.observe([&](Universe& u) {
+        if (member.control)
+            member.control(u);
+        if (!probe.is_free())
+        {
+            // Captured after launch means it hit something.  Report the last free state.
+            if (launched)
+            {
+                impact = true;
+                runner.stop();
+            }
+            return;
+        }
+        launched = true;
+        r = probe.r_cm();
+        v = probe.v_cm();
+        if (world.intersects(probe))
+        {
+            impact = true;
+            runner.stop();
+        }
+    });
+    runner.run(duration);
+
+    auto r_rel{world.rotate_in(r - world.r_cm())};
+    auto v_rel{world.rotate_in(v - world.v_cm())};
+    auto [lat, lon, alt] = world.location(r);
+    return {0, all.time(), impact, r_rel, v_rel,
+            elements(r_rel, v_rel, consts::G*world.m()), lat, lon};
+}
+
+Spread spread(std::vector<double> const& x, std::vector<char> const& impact, bool select)
+{
+    auto n{0.0};
+    auto sum{0.0};
+    for (std::size_t i = 0; i < x.size(); ++i)
+        if (static_cast<bool>(impact[i]) == select)
+        {
+            sum += x[i];
+            ++n;
+        }
+    if (n == 0)
+        return {0.0, 0.0};
+
+    auto mean{sum/n};
+    auto sum2{0.0};
+    for (std::size_t i = 0; i < x.size(); ++i)
+        if (static_cast<bool>(impact[i]) == select)
+            sum2 += (x[i] - mean)*(x[i] - mean);
+    return {mean, std::sqrt(sum2/n)};
+}
+}
+
+Ensemble::Ensemble(std::size_t size, Factory factory)
+    : m_size(size),
+      m_factory(factory)
+{
+}
+
+void Ensemble::run(double duration, double step, Observer observer, unsigned threads)
+{
+    for (auto* column : {&m_time, &m_a, &m_e, &m_i, &m_periapsis, &m_apoapsis,
+                         &m_lat, &m_lon})
+        column->assign(m_size, 0.0);
+    m_impact.assign(m_size, false);
+    m_r.assign(m_size, V0);
+    m_v.assign(m_size, V0);
+
+    std::mutex observer_mutex;
+    parallel_for(m_size, [&](std::size_t index) {
+        auto member{m_factory(index)};
+        assert(member.universe && member.world && member.probe);
+        auto out{propagate(member, duration, step)};
+        out.index = index;
+
+        // Each member writes only its own row.
+        m_time[index] = out.time;
+        m_impact[index] = out.impact;
+        m_r[index] = out.r;
+        m_v[index] = out.v;
+        m_a[index] = out.orbit.a;
+        m_e[index] = out.orbit.e;
+        m_i[index] = out.orbit.i;
+        m_periapsis[index] = out.orbit.periapsis;
+        m_apoapsis[index] = out.orbit.apoapsis;
+        m_lat[index] = out.lat;
+        m_lon[index] = out.lon;
+
+        if (observer)
+        {
+            std::lock_guard lock(observer_mutex);
+            observer(out);
+        }
+    }, threads);
+}
+
+std::size_t Ensemble::size() const
+{
+    return m_size;
+}
+
+Outcome Ensemble::outcome(std::size_t index) const
+{
+    assert(index < m_time.size());
+    return {index, m_time[index], static_cast<bool>(m_impact[index]),
+            m_r[index], m_v[index],
+            {m_a[index], m_e[index], m_i[index], m_periapsis[index], m_apoapsis[index]},
+            m_lat[index], m_lon[index]};
+}
+
+Summary Ensemble::summary() const
+{
+    auto impacts{static_cast<std::size_t>(std::count(m_impact.begin(), m_impact.end(), 1))};
+    return {m_impact.size() - impacts, impacts,
+            spread(m_a, m_impact, false),
+            spread(m_e, m_impact, false),
+            spread(m_i, m_impact, false),
+            spread(m_lat, m_impact, true),
+            spread(m_lon, m_impact, true)};
+}
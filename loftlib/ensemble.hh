@@ -0,0 +1,123 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_ENSEMBLE_HH_INCLUDED
+#define LOFT_LOFTLIB_ENSEMBLE_HH_INCLUDED
+
+#include "orbit.hh"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class Body;
+class Universe;
+class World;
+
+/// One independent copy of a scenario.
+struct Member
+{
+    std::shared_ptr<Universe> universe;
+    /// The central body for orbital elements and impacts.
+    std::shared_ptr<World> world;
+    /// The body whose fate is recorded.
+    std::shared_ptr<Body> probe;
+    /// Called after each step, e.g. to throttle or stage.  May be empty.
+    std::function<void(Universe&)> control;
+};
+
+/// The final state of one member's probe.
+struct Outcome
+{
+    std::size_t index; ///< The member's index in the ensemble.
+    double time; ///< The time of impact, or the end of the run.
+    bool impact; ///< True if the probe hit the world after being free.
+    V3 r; ///< Position relative to the world's center in the world's axes.
+    V3 v; ///< Velocity relative to the world's center in the world's axes.
+    Elements orbit;
+    double lat; ///< Latitude of the impact or the final sub-probe point.
+    double lon; ///< Longitude of the impact or the final sub-probe point.
+};
+
+/// Mean and standard deviation of a quantity over an ensemble.
+struct Spread
+{
+    double mean;
+    double sd;
+};
+
+/// Dispersion statistics over an ensemble.
+struct Summary
+{
+    std::size_t orbits; ///< The number of probes that did not hit the world.
+    std::size_t impacts; ///< The number of probes that hit the world.
+    Spread a; ///< Semi-major axis of probes that did not hit.
+    Spread e; ///< Eccentricity of probes that did not hit.
+    Spread i; ///< Inclination of probes that did not hit.
+    Spread lat; ///< Latitude of impacts.
+    Spread lon; ///< Longitude of impacts.
+};
+
+/// Many independent copies of a scenario propagated in parallel, e.g. with perturbed launch
+/// parameters for Monte Carlo dispersion analysis.  Each member has its own universe so
+/// that members can be stepped on separate threads without sharing state.  Outcomes are
+/// stored by quantity rather than by member.
+class Ensemble
+{
+public:
+    /// Build the member with the given index.
+    using Factory = std::function<Member(std::size_t index)>;
+    using Observer = std::function<void(Outcome const&)>;
+
+    /// @param size The number of members.
+    /// @param factory Called once per member.  Calls are made from worker threads, so the
+    /// factory must not modify shared state.
+    Ensemble(std::size_t size, Factory factory);
+
+    /// Build and propagate every member with a fixed time step.  A member stops early if
+    /// its probe hits the world.
+    /// @param duration How long to run each member.  Rounded to a whole number of steps.
+    /// @param step The time step.
+    /// @param observer Called with each outcome as soon as its member is finished.  Calls
+    /// are serialized but not in index order.
+    /// @param threads The number of workers.  Zero means one per hardware thread.
+    void run(double duration, double step, Observer observer = {}, unsigned threads = 0);
+
+    /// @return The number of members.
+    std::size_t size() const;
+    /// @return The result of the last run for a member.
+    Outcome outcome(std::size_t index) const;
+    /// @return Statistics over all members from the last run.
+    Summary summary() const;
+
+private:
+    std::size_t m_size;
+    Factory m_factory;
+
+    // * Outcome columns indexed by member.
+    std::vector<double> m_time;
+    std::vector<char> m_impact;
+    std::vector<V3> m_r;
+    std::vector<V3> m_v;
+    std::vector<double> m_a;
+    std::vector<double> m_e;
+    std::vector<double> m_i;
+    std::vector<double> m_periapsis;
+    std::vector<double> m_apoapsis;
+    std::vector<double> m_lat;
+    std::vector<double> m_lon;
+};
+
+#endif // LOFT_LOFTLIB_ENSEMBLE_HH_INCLUDED
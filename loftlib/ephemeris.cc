@@ -0,0 +1,218 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "body.hh"
+#include "ephemeris.hh"
+#include "serialize.hh"
+#include "universe.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <numbers>
+
+using namespace std::numbers;
+
+/// Identifies an ephemeris file.
+static constexpr std::array<char, 8> magic{'L', 'o', 'f', 't', 'E', 'p', 'h', 'm'};
+/// The highest degree accepted from a file.  Higher degrees gain nothing in double
+/// precision.
+static constexpr std::uint64_t max_degree{64};
+
+/// @return The number of bytes left in a stream, or -1 if the stream can't seek.
+static std::streamoff remaining(std::istream& is)
+{
+    auto here{is.tellg()};
+    if (here < 0)
+        return -1;
+    is.seekg(0, std::ios::end);
+    auto end{is.tellg()};
+    is.seekg(here);
+    return end - here;
+}
+
+Ephemeris::Ephemeris(double start, double interval, std::size_t degree)
+    : m_start{start},
+      m_interval{interval},
+      m_degree{degree}
+{
+}
+
+std::vector<std::shared_ptr<Ephemeris>>
+Ephemeris::fit(Universe& universe, std::vector<Body_ptr> const& bodies, double duration,
+               double interval, std::size_t degree, double step)
+{
+    assert(interval > 0.0 && step > 0.0);
+    auto start{universe.time()};
+    std::vector<std::shared_ptr<Ephemeris>> ephemerides;
+    for (std::size_t i{0}; i < bodies.size(); ++i)
+        ephemerides.push_back(
+            std::shared_ptr<Ephemeris>(new Ephemeris(start, interval, degree)));
+
+    auto advance_to{[&](double time) {
+        while (universe.time() < time)
+            universe.step(std::min(step, time - universe.time()));
+    }};
+
+    // Node k is at cos(π(k + ½)/n) on [-1, 1].  The nodes run backwards in time, so
+    // visit them in reverse.
+    auto const n{degree + 1};
+    auto segments{static_cast<std::size_t>(std::ceil(duration/interval))};
+    std::vector<std::vector<V3>> samples(bodies.size(), std::vector<V3>(n));
+    for (std::size_t s{0}; s < segments; ++s)
+    {
+        auto t0{start + s*interval};
+        for (auto k{n}; k-- > 0;)
+        {
+            auto x{std::cos(pi*(k + 0.5)/n)};
+            advance_to(t0 + 0.5*(x + 1.0)*interval);
+            for (std::size_t i{0}; i < bodies.size(); ++i)
+                samples[i][k] = universe.origin() + bodies[i]->r_cm();
+        }
+        for (std::size_t i{0}; i < bodies.size(); ++i)
+            ephemerides[i]->add_segment(samples[i]);
+    }
+    advance_to(start + segments*interval);
+    return ephemerides;
+}
+
+void Ephemeris::add_segment(std::vector<V3> const& samples)
+{
+    auto const n{m_degree + 1};
+    assert(samples.size() == n);
+    for (std::size_t j{0}; j < n; ++j)
+    {
+        V3 c{V0};
+        for (std::size_t k{0}; k < n; ++k)
+            c += std::cos(pi*j*(k + 0.5)/n)*samples[k];
+        // Halve the constant term here so evaluation doesn't have to.
+        m_coefficients.push_back((j == 0 ? 1.0 : 2.0)/n*c);
+    }
+}
+
+double Ephemeris::start() const
+{
+    return m_start;
+}
+
+double Ephemeris::end() const
+{
+    return m_start + m_interval*(m_coefficients.size()/(m_degree + 1));
+}
+
+V3 const* Ephemeris::segment(double time, double& x) const
+{
+    assert(!m_coefficients.empty());
+    auto segments{m_coefficients.size()/(m_degree + 1)};
+    auto s{std::clamp(std::floor((time - m_start)/m_interval), 0.0,
+                      static_cast<double>(segments - 1))};
+    x = 2.0*(time - m_start - s*m_interval)/m_interval - 1.0;
+    return &m_coefficients[static_cast<std::size_t>(s)*(m_degree + 1)];
+}
+
+V3 Ephemeris::position(double time) const
+{
+    double x{0.0};
+    auto c{segment(time, x)};
+    // Build Tⱼ(x) with the recurrence Tⱼ₊₁ = 2xTⱼ - Tⱼ₋₁.
+    auto r{c[0]};
+    double T0{1.0};
+    double T1{x};
+    for (std::size_t j{1}; j <= m_degree; ++j)
+    {
+        r += T1*c[j];
+        auto T2{2.0*x*T1 - T0};
+        T0 = T1;
+        T1 = T2;
+    }
+    return r;
+}
+
+V3 Ephemeris::velocity(double time) const
+{
+    double x{0.0};
+    auto c{segment(time, x)};
+    // T'ⱼ = jUⱼ₋₁, where the Uⱼ follow the same recurrence as the Tⱼ with U₁ = 2x.
+    V3 v{V0};
+    double U0{1.0};
+    double U1{2.0*x};
+    for (std::size_t j{1}; j <= m_degree; ++j)
+    {
+        v += (j*U0)*c[j];
+        auto U2{2.0*x*U1 - U0};
+        U0 = U1;
+        U1 = U2;
+    }
+    return (2.0/m_interval)*v;
+}
+
+bool Ephemeris::save(std::ostream& os) const
+{
+    serialize::write(os, magic);
+    serialize::write(os, m_start);
+    serialize::write(os, m_interval);
+    serialize::write(os, static_cast<std::uint64_t>(m_degree));
+    serialize::write(os, static_cast<std::uint64_t>(m_coefficients.size()));
+    for (auto const& c : m_coefficients)
+        serialize::write(os, c);
+    return static_cast<bool>(os);
+}
+
+bool Ephemeris::save(std::string const& path) const
+{
+    std::ofstream os(path, std::ios::binary);
+    return os && save(os) && os.flush();
+}
+
+std::shared_ptr<Ephemeris> Ephemeris::load(std::istream& is)
+{
+    std::array<char, 8> file_magic{};
+    double start{0.0};
+    double interval{0.0};
+    std::uint64_t degree{0};
+    std::uint64_t n{0};
+    serialize::read(is, file_magic);
+    serialize::read(is, start);
+    serialize::read(is, interval);
+    serialize::read(is, degree);
+    serialize::read(is, n);
+    if (!is || file_magic != magic || interval <= 0.0 || degree > max_degree || n == 0
+        || n % (degree + 1) != 0)
+        return nullptr;
+    // Don't allocate more than the stream can fill.  If it can't seek, the coefficients
+    // are only stored as they're read.
+    auto left{remaining(is)};
+    if (left >= 0 && n > static_cast<std::uint64_t>(left)/sizeof(V3))
+        return nullptr;
+    std::shared_ptr<Ephemeris> ephemeris(new Ephemeris(start, interval, degree));
+    if (left >= 0)
+        ephemeris->m_coefficients.reserve(n);
+    for (std::uint64_t i{0}; i < n && is; ++i)
+    {
+        auto c{V0};
+        serialize::read(is, c);
+        ephemeris->m_coefficients.push_back(c);
+    }
+    return is ? ephemeris : nullptr;
+}
+
+std::shared_ptr<Ephemeris> Ephemeris::load(std::string const& path)
+{
+    std::ifstream is(path, std::ios::binary);
+    return is ? load(is) : nullptr;
+}
@@ -0,0 +1,83 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_EPHEMERIS_HH_INCLUDED
+#define LOFT_LOFTLIB_EPHEMERIS_HH_INCLUDED
+
+#include "three-vector.hh"
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Body;
+class Universe;
+
+/// A body's path as a sequence of Chebyshev polynomials in time, one per fixed-length
+/// segment.  Position and velocity are evaluated in constant time anywhere in the span,
+/// so bodies whose motion is known in advance don't have to be integrated.
+class Ephemeris
+{
+public:
+    using Body_ptr = std::shared_ptr<Body>;
+
+    /// Run a universe and fit an ephemeris to the center of mass of each of the given
+    /// bodies.  Positions are absolute, so the universe's origin may move during the
+    /// fit.  The universe is left at the end of the span.
+    /// @param duration The length of the span starting at the universe's time: s
+    /// @param interval The length of each segment: s
+    /// @param degree The degree of each segment's polynomial.
+    /// @param step The longest step to take when running the universe: s
+    /// @return The ephemerides in the order of the bodies.
+    static std::vector<std::shared_ptr<Ephemeris>>
+    fit(Universe& universe, std::vector<Body_ptr> const& bodies, double duration,
+        double interval, std::size_t degree, double step);
+
+    /// @return The start and end of the span: s
+    double start() const;
+    double end() const;
+    /// @return Position and velocity at a time.  Times outside the span are extrapolated
+    /// from the nearest segment, which quickly becomes inaccurate.
+    V3 position(double time) const;
+    V3 velocity(double time) const;
+
+    /// Write the ephemeris to a binary stream in the machine's native format.
+    /// @return False if the stream could not be written.
+    bool save(std::ostream& os) const;
+    bool save(std::string const& path) const;
+    /// Read an ephemeris written by save().
+    /// @return The ephemeris, or nullptr if the stream does not hold one.
+    static std::shared_ptr<Ephemeris> load(std::istream& is);
+    static std::shared_ptr<Ephemeris> load(std::string const& path);
+
+private:
+    Ephemeris(double start, double interval, std::size_t degree);
+
+    /// Fit a segment to positions sampled at the Chebyshev nodes of the next segment.
+    void add_segment(std::vector<V3> const& samples);
+    /// @return The coefficients of the segment that holds a time.
+    /// @param x Set to the time scaled to [-1, 1] within the segment.
+    V3 const* segment(double time, double& x) const;
+
+    double m_start;
+    double m_interval;
+    std::size_t m_degree;
+    /// Degree + 1 coefficients for each segment, lowest order first.
+    std::vector<V3> m_coefficients;
+};
+
+#endif // LOFT_LOFTLIB_EPHEMERIS_HH_INCLUDED
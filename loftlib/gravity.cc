@@ -0,0 +1,122 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "body.hh"
+#include "gravity.hh"
+#include "units.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+void Mixed_Gravity::load(std::vector<Body*> const& bodies)
+{
+    auto const n{bodies.size()};
+    for (auto* column : {&m_x, &m_y, &m_z, &m_gm, &m_ax, &m_ay, &m_az, &m_phi})
+        column->assign(n, 0.0f);
+    m_mass_group.resize(n);
+    m_scripted.resize(n);
+
+    auto center{V0};
+    for (auto const* b : bodies)
+        center += b->r_cm();
+    center = center/static_cast<double>(n);
+    for (std::size_t i{0}; i < n; ++i)
+    {
+        auto r{bodies[i]->r_cm() - center};
+        m_x[i] = static_cast<float>(r.x);
+        m_y[i] = static_cast<float>(r.y);
+        m_z[i] = static_cast<float>(r.z);
+        m_gm[i] = static_cast<float>(consts::G*bodies[i]->m());
+        m_scripted[i] = bodies[i]->is_scripted();
+    }
+    // Number the distinct masses.  Masses are compared in double precision, since
+    // different masses may round to the same float.
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&bodies](std::size_t i, std::size_t j) {
+        return bodies[i]->m() < bodies[j]->m();
+    });
+    std::int32_t group{0};
+    for (std::size_t k{0}; k < n; ++k)
+    {
+        if (k > 0 && bodies[order[k]]->m() != bodies[order[k - 1]]->m())
+            ++group;
+        m_mass_group[order[k]] = group;
+    }
+}
+
+/// Add the accelerations toward one body to the accelerations of all the bodies, and
+/// optionally its potential to their potentials.  The arrays don't overlap, and saying so
+/// lets the loop be vectorized without run-time checks.
+template <bool with_potential>
+static void attract(std::size_t i, std::size_t n, float const* __restrict x,
+                    float const* __restrict y, float const* __restrict z,
+                    float const* __restrict gm, std::int32_t const* __restrict group,
+                    std::int32_t const* __restrict scripted, float* __restrict ax,
+                    float* __restrict ay, float* __restrict az, float* __restrict phi)
+{
+    auto const x_i{x[i]};
+    auto const y_i{y[i]};
+    auto const z_i{z[i]};
+    auto const gm_i{gm[i]};
+    auto const group_i{group[i]};
+    auto const scripted_i{scripted[i]};
+    for (std::size_t j{0}; j < n; ++j)
+    {
+        auto dx{x_i - x[j]};
+        auto dy{y_i - y[j]};
+        auto dz{z_i - z[j]};
+        auto r2{dx*dx + dy*dy + dz*dz};
+        // Skipped pairs are multiplied by zero rather than branched around.  A body is
+        // in its own mass group, so it doesn't attract itself.
+        auto on{static_cast<float>((r2 >= 1e-3f) & (group[j] != group_i)
+                                   & ((scripted[j] & scripted_i) == 0))};
+        auto inv_r{1.0f/std::sqrt(r2 + (1.0f - on))};
+        auto k{on*gm_i*inv_r*inv_r*inv_r};
+        ax[j] += k*dx;
+        ay[j] += k*dy;
+        az[j] += k*dz;
+        // k r² is gm/r, or zero for a skipped pair.
+        if constexpr (with_potential)
+            phi[j] -= k*r2;
+    }
+}
+
+double Mixed_Gravity::apply(std::vector<Body*> const& bodies, double time,
+                            bool with_potential)
+{
+    if (bodies.size() < 2)
+        return 0.0;
+    load(bodies);
+    auto const n{bodies.size()};
+    // Visit every ordered pair.  That's twice the pairs of visiting each once, but the
+    // inner loop carries no sums from one iteration to the next, so it vectorizes
+    // without reordering the arithmetic.
+    auto* attract_i{with_potential ? attract<true> : attract<false>};
+    for (std::size_t i{0}; i < n; ++i)
+        attract_i(i, n, m_x.data(), m_y.data(), m_z.data(), m_gm.data(),
+                  m_mass_group.data(), m_scripted.data(), m_ax.data(), m_ay.data(),
+                  m_az.data(), m_phi.data());
+    double potential{0.0};
+    for (std::size_t i{0}; i < n; ++i)
+    {
+        auto m{bodies[i]->m()};
+        bodies[i]->impulse(m*time*V3(m_ax[i], m_ay[i], m_az[i]));
+        // Each pair was visited twice.
+        potential += 0.5*m*m_phi[i];
+    }
+    return potential;
+}
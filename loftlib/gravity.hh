@@ -0,0 +1,59 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_GRAVITY_HH_INCLUDED
+#define LOFT_LOFTLIB_GRAVITY_HH_INCLUDED
+
+#include "three-vector.hh"
+
+#include <cstdint>
+#include <vector>
+
+class Body;
+
+/// Pairwise gravity between point masses evaluated in single precision.  Positions are
+/// taken relative to the bodies' mean position in double precision and then rounded to
+/// float, so the rounding error is relative to the size of the group of bodies rather
+/// than to their distance from the origin.  The arrays are laid out by quantity so that
+/// the inner loop can use the full width of the vector registers.  Impulses are summed
+/// and applied in double precision.
+class Mixed_Gravity
+{
+public:
+    /// Apply the impulses from each pair of bodies' gravity over a time step.  Pairs are
+    /// skipped as in the double-precision path: bodies of equal mass, pairs that are both
+    /// scripted, and pairs closer than about 3 cm.
+    /// @param with_potential Sum the potential energy in the same pass.
+    /// @return The potential energy of the pairs that attract each other if
+    /// with_potential is true, otherwise zero: J
+    double apply(std::vector<Body*> const& bodies, double time,
+                 bool with_potential = false);
+
+private:
+    /// Copy the bodies' state into the arrays.
+    void load(std::vector<Body*> const& bodies);
+
+    // One entry per body.
+    std::vector<float> m_x, m_y, m_z; ///< Position relative to the mean: m
+    std::vector<float> m_gm; ///< Gravitational parameter: m³/s²
+    /// Bodies with equal masses have the same group number.
+    std::vector<std::int32_t> m_mass_group;
+    /// 1 for scripted bodies, else 0.
+    std::vector<std::int32_t> m_scripted;
+    std::vector<float> m_ax, m_ay, m_az; ///< Acceleration: m/s²
+    std::vector<float> m_phi; ///< Gravitational potential: m²/s²
+};
+
+#endif // LOFT_LOFTLIB_GRAVITY_HH_INCLUDED
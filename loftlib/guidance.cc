@@ -0,0 +1,206 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "guidance.hh"
+#include "rocket.hh"
+#include "world.hh"
+
+#include <algorithm>
+#include <cmath>
+
+void Guidance_Batch::resize(std::size_t n)
+{
+    for (auto* column : {&rx, &ry, &rz, &vx, &vy, &vz, &wx, &wy, &wz, &ex, &ey, &ez,
+                         &mu, &radius, &accel, &dx, &dy, &dz, &throttle})
+        column->resize(n);
+}
+
+std::size_t Guidance_Batch::size() const
+{
+    return rx.size();
+}
+
+/// Compute thrust commands for n vehicles.  The columns don't overlap, and saying so lets
+/// the loop be vectorized without run-time checks.  Every quantity is computed for every
+/// vehicle and the results are selected rather than branched between.
+static void guide(Ascent const& ascent, std::size_t n, double const* __restrict rx,
+                  double const* __restrict ry, double const* __restrict rz,
+                  double const* __restrict vx, double const* __restrict vy,
+                  double const* __restrict vz, double const* __restrict wx,
+                  double const* __restrict wy, double const* __restrict wz,
+                  double const* __restrict ex, double const* __restrict ey,
+                  double const* __restrict ez, double const* __restrict mu,
+                  double const* __restrict radius, double const* __restrict accel,
+                  double* __restrict dx, double* __restrict dy, double* __restrict dz,
+                  double* __restrict throttle)
+{
+    auto const cos_kick{std::cos(ascent.kick)};
+    auto const sin_kick{std::sin(ascent.kick)};
+    auto const turn_speed{ascent.turn_speed};
+    auto const altitude{ascent.altitude};
+    auto const handover{ascent.handover};
+    auto const min_time{ascent.min_time};
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        // Radial and horizontal components.
+        auto r{std::sqrt(rx[i]*rx[i] + ry[i]*ry[i] + rz[i]*rz[i])};
+        auto ux{rx[i]/r};
+        auto uy{ry[i]/r};
+        auto uz{rz[i]/r};
+        auto v_r{vx[i]*ux + vy[i]*uy + vz[i]*uz};
+        auto hx{vx[i] - v_r*ux};
+        auto hy{vy[i] - v_r*uy};
+        auto hz{vz[i] - v_r*uz};
+        auto v_h{std::sqrt(hx*hx + hy*hy + hz*hz)};
+        // Horizontal direction: along the velocity, or downrange if there's no
+        // horizontal velocity yet.
+        auto moving{v_h > 1e-6};
+        auto inv_h{1.0/(moving ? v_h : 1.0)};
+        hx *= inv_h;
+        hy *= inv_h;
+        hz *= inv_h;
+        hx = moving ? hx : ex[i];
+        hy = moving ? hy : ey[i];
+        hz = moving ? hz : ez[i];
+
+        // Gravity turn: rise vertically, tip downrange by the kick angle, and then follow
+        // the velocity relative to the ground once it has tipped as far.
+        auto sx{vx[i] - wx[i]};
+        auto sy{vy[i] - wy[i]};
+        auto sz{vz[i] - wz[i]};
+        auto speed{std::sqrt(sx*sx + sy*sy + sz*sz)};
+        auto stopped{speed == 0.0};
+        auto inv_speed{1.0/(stopped ? 1.0 : speed)};
+        inv_speed = stopped ? 0.0 : inv_speed;
+        auto rising{speed < turn_speed};
+        auto tipped{(sx*ux + sy*uy + sz*uz)*inv_speed < cos_kick};
+        auto kx{cos_kick*ux + sin_kick*ex[i]};
+        auto ky{cos_kick*uy + sin_kick*ey[i]};
+        auto kz{cos_kick*uz + sin_kick*ez[i]};
+        sx *= inv_speed;
+        sy *= inv_speed;
+        sz *= inv_speed;
+        auto gx{rising ? ux : tipped ? sx : kx};
+        auto gy{rising ? uy : tipped ? sy : ky};
+        auto gz{rising ? uz : tipped ? sz : kz};
+
+        // Explicit guidance: the radial acceleration that reaches the target radius with
+        // no radial velocity in the time it takes to reach circular speed.
+        auto a{accel[i]};
+        auto target{radius[i] + altitude};
+        auto v_circ{std::sqrt(mu[i]/target)};
+        auto t_go{(v_circ - v_h)/(a > 1e-9 ? a : 1e-9)};
+        t_go = t_go > min_time ? t_go : min_time;
+        auto a_r{6.0*(target - r)/(t_go*t_go) - 4.0*v_r/t_go + mu[i]/(r*r) - v_h*v_h/r};
+        a_r = a_r < -a ? -a : a_r > a ? a : a_r;
+        auto a_h2{a*a - a_r*a_r};
+        auto a_h{std::sqrt(a_h2 > 0.0 ? a_h2 : 0.0)};
+        auto powered{a > 0.0};
+        auto inv_a{1.0/(powered ? a : 1.0)};
+        auto eg_r{a_r*inv_a};
+        auto eg_h{a_h*inv_a};
+        eg_r = powered ? eg_r : 1.0;
+        eg_h = powered ? eg_h : 0.0;
+        auto ex_x{eg_r*ux + eg_h*hx};
+        auto ex_y{eg_r*uy + eg_h*hy};
+        auto ex_z{eg_r*uz + eg_h*hz};
+
+        auto closed{r - radius[i] > handover};
+        dx[i] = closed ? ex_x : gx;
+        dy[i] = closed ? ex_y : gy;
+        dz[i] = closed ? ex_z : gz;
+        throttle[i] = v_h < v_circ ? 1.0 : 0.0;
+    }
+}
+
+void guide(Ascent const& ascent, Guidance_Batch& b)
+{
+    guide(ascent, b.size(), b.rx.data(), b.ry.data(), b.rz.data(), b.vx.data(),
+          b.vy.data(), b.vz.data(), b.wx.data(), b.wy.data(), b.wz.data(), b.ex.data(),
+          b.ey.data(), b.ez.data(), b.mu.data(), b.radius.data(), b.accel.data(),
+          b.dx.data(), b.dy.data(), b.dz.data(), b.throttle.data());
+}
+
+Guidance::Guidance(Ascent const& ascent)
+    : m_ascent(ascent)
+{
+}
+
+void Guidance::add(std::shared_ptr<Rocket> rocket, std::shared_ptr<World> world)
+{
+    m_rockets.push_back(rocket);
+    m_worlds.push_back(world);
+    m_done.push_back(false);
+}
+
+void Guidance::update()
+{
+    auto n{m_rockets.size()};
+    m_batch.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto const& rocket{*m_rockets[i]};
+        auto const& world{*m_worlds[i]};
+        // The rocket moves with the world until it's released.
+        auto r{rocket.is_free() ? rocket.r_cm() : rocket.transform_out(V0)};
+        r -= world.r_cm();
+        auto ground{cross(world.omega(), r)};
+        auto v{rocket.is_free() ? rocket.v_cm() - world.v_cm() : ground};
+        // Downrange is east: the direction of the world's rotation.
+        auto east{unit(cross(world.rotate_out(Vz), r))};
+        auto& b{m_batch};
+        b.rx[i] = r.x;
+        b.ry[i] = r.y;
+        b.rz[i] = r.z;
+        b.vx[i] = v.x;
+        b.vy[i] = v.y;
+        b.vz[i] = v.z;
+        b.wx[i] = ground.x;
+        b.wy[i] = ground.y;
+        b.wz[i] = ground.z;
+        b.ex[i] = east.x;
+        b.ey[i] = east.y;
+        b.ez[i] = east.z;
+        b.mu[i] = consts::G*world.m();
+        b.radius[i] = world.radius();
+        b.accel[i] = rocket.max_thrust()/rocket.m();
+    }
+    guide(m_ascent, m_batch);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (m_done[i])
+            continue;
+        auto& rocket{*m_rockets[i]};
+        if (m_batch.throttle[i] == 0.0 && rocket.is_free())
+        {
+            // Cut off for good.
+            m_done[i] = true;
+            rocket.throttle(0.0);
+            continue;
+        }
+        rocket.throttle(m_batch.throttle[i]);
+        rocket.point_thrust(V3(m_batch.dx[i], m_batch.dy[i], m_batch.dz[i]));
+    }
+}
+
+void Guidance::observe(Universe const&)
+{
+    update();
+}
+
+bool Guidance::done(std::size_t index) const
+{
+    return m_done[index];
+}
@@ -0,0 +1,93 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_GUIDANCE_HH_INCLUDED
+#define LOFT_LOFTLIB_GUIDANCE_HH_INCLUDED
+
+#include "units.hh"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class Rocket;
+class Universe;
+class World;
+
+/// The flight plan for an ascent to a circular orbit.
+struct Ascent
+{
+    double altitude{2e5}; ///< Altitude of the target orbit: m
+    double turn_speed{100.0}; ///< Speed at which the pitch-over starts: m/s
+    double kick{units::deg(1.0)}; ///< Initial pitch-over angle from vertical: rad
+    double handover{2e4}; ///< Altitude where explicit guidance takes over: m
+    double min_time{1.0}; ///< Shortest time-to-go used by explicit guidance: s
+};
+
+/// The state of many vehicles, one column per quantity.  Positions and velocities are
+/// relative to the center of the vehicle's world.
+struct Guidance_Batch
+{
+    // Inputs
+    std::vector<double> rx, ry, rz;
+    std::vector<double> vx, vy, vz;
+    std::vector<double> wx, wy, wz; ///< Velocity of the ground beneath the vehicle.
+    std::vector<double> ex, ey, ez; ///< Downrange direction for the pitch-over.
+    std::vector<double> mu; ///< The world's gravitational parameter.
+    std::vector<double> radius; ///< The world's radius.
+    std::vector<double> accel; ///< Thrust acceleration at full throttle.
+    // Outputs
+    std::vector<double> dx, dy, dz; ///< Thrust direction.
+    std::vector<double> throttle;
+
+    void resize(std::size_t n);
+    std::size_t size() const;
+};
+
+/// Compute thrust commands for a batch of vehicles flying the same ascent.  The vehicle
+/// rises vertically until it reaches the turn speed, tips over by the kick angle, and
+/// then thrusts along its velocity relative to the ground in a gravity turn.  Above the
+/// handover altitude, explicit guidance steers it so that the radial acceleration brings
+/// it to the target radius with zero radial velocity just as it reaches circular speed.
+/// Throttle goes to zero when horizontal speed reaches circular speed.  Every quantity is
+/// computed for every vehicle and the results are selected rather than branched between,
+/// so the loop is vectorized at -O3.
+void guide(Ascent const& ascent, Guidance_Batch& batch);
+
+/// Flies rockets to orbit.  Rockets from any number of universes may be added.  Their
+/// guidance is computed together by guide() on each update.
+class Guidance
+{
+public:
+    explicit Guidance(Ascent const& ascent);
+
+    /// Fly a rocket launched from a world.
+    void add(std::shared_ptr<Rocket> rocket, std::shared_ptr<World> world);
+    /// Compute and apply thrust commands for all rockets.  Call each control tick.
+    void update();
+    /// Suitable for Runner::observe() when all rockets are in one universe.
+    void observe(Universe const& universe);
+    /// @return True if the rocket with the given index has cut off its engine.
+    bool done(std::size_t index) const;
+
+private:
+    Ascent m_ascent;
+    std::vector<std::shared_ptr<Rocket>> m_rockets;
+    std::vector<std::shared_ptr<World>> m_worlds;
+    std::vector<bool> m_done;
+    Guidance_Batch m_batch;
+};
+
+#endif // LOFT_LOFTLIB_GUIDANCE_HH_INCLUDED
@@ -0,0 +1,157 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "harmonics.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+/// EGM96 normalized coefficients through degree and order 4.
+static std::vector<Harmonics::Term> const egm96{
+    {2, 0, -0.484165371736e-3, 0.0},
+    {2, 1, -0.186987635955e-9, 0.119528012031e-8},
+    {2, 2, 0.243914352398e-5, -0.140016683654e-5},
+    {3, 0, 0.957254173792e-6, 0.0},
+    {3, 1, 0.202998882184e-5, 0.248513158716e-6},
+    {3, 2, 0.904627768605e-6, -0.619025944205e-6},
+    {3, 3, 0.721072657057e-6, 0.141435626958e-5},
+    {4, 0, 0.539873863789e-6, 0.0},
+    {4, 1, -0.536321616971e-6, -0.473440265853e-6},
+    {4, 2, 0.350694105785e-6, 0.662671572540e-6},
+    {4, 3, 0.990771803829e-6, -0.200928369177e-6},
+    {4, 4, -0.188560802735e-6, 0.308853169333e-6},
+};
+
+/// EGM96 reference radius: m
+static constexpr double egm96_radius{6378136.3};
+
+Harmonics::Harmonics(double radius, std::vector<Term> const& terms)
+    : m_radius{radius}
+{
+    for (auto const& t : terms)
+        m_degree = std::max(m_degree, t.degree);
+    m_C.resize(index(m_degree + 1, 0), 0.0);
+    m_S.resize(m_C.size(), 0.0);
+    for (auto const& t : terms)
+    {
+        assert(t.order <= t.degree);
+        auto n{static_cast<double>(t.degree)};
+        auto m{static_cast<double>(t.order)};
+        // Undo the normalization so the recursion doesn't need it.
+        auto ratio{std::exp(std::lgamma(n - m + 1.0) - std::lgamma(n + m + 1.0))};
+        auto norm{std::sqrt((t.order == 0 ? 1.0 : 2.0)*(2.0*n + 1.0)*ratio)};
+        m_C[index(t.degree, t.order)] = norm*t.C;
+        m_S[index(t.degree, t.order)] = norm*t.S;
+    }
+}
+
+std::shared_ptr<Harmonics const> Harmonics::earth()
+{
+    static auto const field{std::make_shared<Harmonics const>(egm96_radius, egm96)};
+    return field;
+}
+
+std::size_t Harmonics::degree() const
+{
+    return m_degree;
+}
+
+double Harmonics::radius() const
+{
+    return m_radius;
+}
+
+std::size_t Harmonics::index(std::size_t n, std::size_t m)
+{
+    return n*(n + 1)/2 + m;
+}
+
+V3 Harmonics::acceleration(V3 const& r, double mu, std::size_t degree, std::size_t order,
+                           Workspace& work) const
+{
+    auto N{std::min(degree, m_degree)};
+    auto M{std::min(order, N)};
+    auto r2{dot(r, r)};
+    if (N < 2 || r2 == 0.0)
+        return V0;
+
+    // V and W are the real and imaginary parts of the solid harmonics through degree and
+    // order N+1, stored in rows of N+2.
+    auto const stride{N + 2};
+    auto const size{stride*stride};
+    if (work.V.size() < size)
+    {
+        work.V.resize(size);
+        work.W.resize(size);
+    }
+    auto V{[&](std::size_t n, std::size_t m) -> double& { return work.V[n*stride + m]; }};
+    auto W{[&](std::size_t n, std::size_t m) -> double& { return work.W[n*stride + m]; }};
+
+    auto R{m_radius};
+    auto rho{R*R/r2};
+    auto x0{R*r.x/r2};
+    auto y0{R*r.y/r2};
+    auto z0{R*r.z/r2};
+
+    // Zonal terms.
+    V(0, 0) = R/std::sqrt(r2);
+    W(0, 0) = 0.0;
+    V(1, 0) = z0*V(0, 0);
+    W(1, 0) = 0.0;
+    for (std::size_t n{2}; n <= N + 1; ++n)
+    {
+        V(n, 0) = ((2*n - 1)*z0*V(n - 1, 0) - (n - 1)*rho*V(n - 2, 0))/n;
+        W(n, 0) = 0.0;
+    }
+    // Tesseral and sectoral terms.
+    for (std::size_t m{1}; m <= M + 1; ++m)
+    {
+        V(m, m) = (2*m - 1)*(x0*V(m - 1, m - 1) - y0*W(m - 1, m - 1));
+        W(m, m) = (2*m - 1)*(x0*W(m - 1, m - 1) + y0*V(m - 1, m - 1));
+        if (m <= N)
+        {
+            V(m + 1, m) = (2*m + 1)*z0*V(m, m);
+            W(m + 1, m) = (2*m + 1)*z0*W(m, m);
+        }
+        for (std::size_t n{m + 2}; n <= N + 1; ++n)
+        {
+            V(n, m) = ((2*n - 1)*z0*V(n - 1, m) - (n + m - 1)*rho*V(n - 2, m))/(n - m);
+            W(n, m) = ((2*n - 1)*z0*W(n - 1, m) - (n + m - 1)*rho*W(n - 2, m))/(n - m);
+        }
+    }
+
+    V3 a{V0};
+    for (std::size_t m{0}; m <= M; ++m)
+        for (std::size_t n{std::max(m, std::size_t{2})}; n <= N; ++n)
+        {
+            auto C{m_C[index(n, m)]};
+            auto S{m_S[index(n, m)]};
+            if (m == 0)
+            {
+                a.x -= C*V(n + 1, 1);
+                a.y -= C*W(n + 1, 1);
+                a.z -= (n + 1)*C*V(n + 1, 0);
+                continue;
+            }
+            auto f{0.5*(n - m + 1)*(n - m + 2)};
+            a.x += 0.5*(-C*V(n + 1, m + 1) - S*W(n + 1, m + 1))
+                + f*(C*V(n + 1, m - 1) + S*W(n + 1, m - 1));
+            a.y += 0.5*(-C*W(n + 1, m + 1) + S*V(n + 1, m + 1))
+                + f*(-C*W(n + 1, m - 1) + S*V(n + 1, m - 1));
+            a.z += (n - m + 1)*(-C*V(n + 1, m) - S*W(n + 1, m));
+        }
+    return mu/(R*R)*a;
+}
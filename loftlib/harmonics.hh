@@ -0,0 +1,83 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_HARMONICS_HH_INCLUDED
+#define LOFT_LOFTLIB_HARMONICS_HH_INCLUDED
+
+#include "three-vector.hh"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/// A world's gravity field as a series of spherical harmonics.  Only the terms of degree
+/// 2 and up are evaluated.  The central term is the point-mass gravity that the universe
+/// already applies, and the degree-1 terms vanish about the center of mass.
+class Harmonics
+{
+public:
+    /// A fully normalized coefficient pair.
+    struct Term
+    {
+        std::size_t degree;
+        std::size_t order;
+        double C;
+        double S;
+    };
+
+    /// Scratch space for acceleration().  Keeping one per world means evaluations don't
+    /// allocate.
+    struct Workspace
+    {
+        std::vector<double> V;
+        std::vector<double> W;
+    };
+
+    /// @param radius The reference radius of the coefficients: m
+    /// @param terms Normalized coefficients.  Terms that aren't given are zero.
+    Harmonics(double radius, std::vector<Term> const& terms);
+
+    /// @return The Earth's field from EGM96 through degree and order 4, shared by all
+    /// worlds that use it.
+    static std::shared_ptr<Harmonics const> earth();
+
+    /// @return The highest degree with coefficients.
+    std::size_t degree() const;
+    /// @return The reference radius: m
+    double radius() const;
+
+    /// Sum the series with Cunningham's recursion for the solid harmonics.  The recursion
+    /// builds the cos(mλ) and sin(mλ) factors from the position's coordinates, so there
+    /// are no trig calls.
+    /// @param r Position in the world's frame with x at zero longitude and z north: m
+    /// @param mu G times the world's mass: m³/s²
+    /// @param degree, order Terms above these are left out.  They're clamped to the
+    /// field's degree.
+    /// @return The acceleration from the terms of degree 2 and up: m/s²
+    V3 acceleration(V3 const& r, double mu, std::size_t degree, std::size_t order,
+                    Workspace& work) const;
+
+private:
+    /// Index of a coefficient in the triangular tables.
+    static std::size_t index(std::size_t n, std::size_t m);
+
+    double m_radius;
+    std::size_t m_degree{0};
+    /// Unnormalized coefficients.
+    std::vector<double> m_C;
+    std::vector<double> m_S;
+};
+
+#endif // LOFT_LOFTLIB_HARMONICS_HH_INCLUDED
@@ -0,0 +1,107 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "atmosphere.hh"
+#include "harmonics.hh"
+#include "launch.hh"
+#include "rocket.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+/// Parameter names and the corresponding members in the same order.
+using Parameter = std::pair<std::string, double Launch::*>;
+static std::vector<Parameter> const parameters{
+    {"lat", &Launch::lat},
+    {"lon", &Launch::lon},
+    {"shell_mass", &Launch::shell_mass},
+    {"engine_mass", &Launch::engine_mass},
+    {"radius", &Launch::radius},
+    {"length", &Launch::length},
+    {"fuel_density", &Launch::fuel_density},
+    {"specific_impulse", &Launch::specific_impulse},
+    {"fuel_rate", &Launch::fuel_rate},
+    {"throttle", &Launch::throttle},
+    {"release_time", &Launch::release_time},
+    {"turn_time", &Launch::turn_time},
+    {"turn", &Launch::turn},
+    {"straight_time", &Launch::straight_time},
+    {"drag_area", &Launch::drag_area},
+    {"gravity_degree", &Launch::gravity_degree},
+    {"gravity_order", &Launch::gravity_order},
+};
+
+std::vector<std::string> const& Launch::names()
+{
+    static auto const names{[] {
+        std::vector<std::string> v;
+        for (auto const& p : parameters)
+            v.push_back(p.first);
+        return v;
+    }()};
+    return names;
+}
+
+bool Launch::set(std::string const& name, double value)
+{
+    auto it{std::find_if(parameters.begin(), parameters.end(),
+                         [&name](Parameter const& p) { return p.first == name; })};
+    if (it == parameters.end())
+        return false;
+    this->*(it->second) = value;
+    return true;
+}
+
+double Launch::get(std::string const& name) const
+{
+    auto it{std::find_if(parameters.begin(), parameters.end(),
+                         [&name](Parameter const& p) { return p.first == name; })};
+    assert(it != parameters.end());
+    return this->*(it->second);
+}
+
+Member Launch::build() const
+{
+    using namespace consts;
+
+    auto orientation{rot(M1, units::deg(23.44)*Vy)};
+    auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, orientation,
+                                       units::day(1.0))};
+    earth->set_atmosphere(Atmosphere::standard());
+    if (gravity_degree >= 2.0)
+        earth->set_harmonics(Harmonics::earth(), static_cast<std::size_t>(gravity_degree),
+                             static_cast<std::size_t>(gravity_order));
+    auto [r_pad, m] = earth->locate(lat, lon, 1);
+    auto rocket{std::make_shared<Rocket>(shell_mass, engine_mass, radius, length,
+                                         fuel_density, specific_impulse, fuel_rate,
+                                         r_pad, m)};
+    rocket->throttle(throttle);
+    rocket->set_drag_area(drag_area);
+    auto all{std::make_shared<Universe>(true)};
+    all->add(earth);
+    all->add(rocket);
+    earth->capture(rocket);
+
+    // The same events as the view.
+    all->schedule(release_time, [earth, rocket](Universe&) { earth->release(rocket); });
+    all->schedule(turn_time, [rocket, turn = turn](Universe&) {
+        rocket->orient_thrust(-turn*Vy);
+    });
+    all->schedule(straight_time, [rocket](Universe&) { rocket->orient_thrust(V0); });
+    return {all, earth, rocket, {}};
+}
@@ -0,0 +1,64 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_LAUNCH_HH_INCLUDED
+#define LOFT_LOFTLIB_LAUNCH_HH_INCLUDED
+
+#include "ensemble.hh"
+#include "units.hh"
+
+#include <string>
+#include <vector>
+
+/// A single-stage rocket launched from the Earth's surface with a scripted pitch-over.
+/// The defaults are the launch from Kennedy Space Center in the view.
+struct Launch
+{
+    double lat{units::dms(28, 31, 27)}; ///< Latitude of the pad: rad
+    double lon{units::dms(-80, 39, 3)}; ///< Longitude of the pad: rad
+    double shell_mass{10}; ///< kg
+    double engine_mass{50}; ///< kg
+    double radius{0.5}; ///< m
+    double length{10}; ///< m
+    double fuel_density{1.2}; ///< kg/m³
+    double specific_impulse{8.0e4}; ///< m/s
+    double fuel_rate{0.01}; ///< m³/s at full throttle.
+    double throttle{1.0}; ///< Fraction of full throttle from ignition.
+    double release_time{1.0}; ///< When the rocket leaves the pad: s
+    double turn_time{110.0}; ///< When the pitch-over starts: s
+    double turn{2e-5}; ///< Engine deflection during the pitch-over: rad
+    double straight_time{142.0}; ///< When the engine is straightened: s
+    /// Drag coefficient times cross-section: m².  The Earth has the standard atmosphere,
+    /// but it only affects the rocket if this is set.
+    double drag_area{0.0};
+    /// The degree and order of the Earth's gravity field.  A degree below 2 makes the
+    /// Earth a point mass.
+    double gravity_degree{0.0};
+    double gravity_order{0.0};
+
+    /// @return The names of the parameters that can be set by name.
+    static std::vector<std::string> const& names();
+    /// Set a parameter by name.
+    /// @return False if there's no parameter with that name.
+    bool set(std::string const& name, double value);
+    /// @return The value of a parameter by name.  The name must be one of names().
+    double get(std::string const& name) const;
+
+    /// @return A new universe with the Earth and the rocket on the pad.  The rocket is the
+    /// probe.  The universe has the release and steering scheduled.
+    Member build() const;
+};
+
+#endif // LOFT_LOFTLIB_LAUNCH_HH_INCLUDED
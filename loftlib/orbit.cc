@@ -0,0 +1,33 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "orbit.hh"
+
+#include <limits>
+
+Elements elements(V3 const& r, V3 const& v, double mu)
+{
+    auto h{cross(r, v)};
+    auto energy{square(v)/2 - mu/mag(r)};
+    auto e{mag(cross(v, h)/mu - unit(r))};
+    auto inf{std::numeric_limits<double>::infinity()};
+    auto a{energy == 0.0 ? inf : -mu/(2*energy)};
+    auto h_mag{mag(h)};
+    return {a,
+            e,
+            h_mag == 0.0 ? 0.0 : std::acos(h.z/h_mag),
+            square(h)/mu/(1 + e),
+            e < 1.0 ? a*(1 + e) : inf};
+}
@@ -0,0 +1,37 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_ORBIT_HH_INCLUDED
+#define LOFT_LOFTLIB_ORBIT_HH_INCLUDED
+
+#include "three-vector.hh"
+
+/// The shape and tilt of a Keplerian orbit about a central body.
+struct Elements
+{
+    double a; ///< Semi-major axis: m.  Negative for hyperbolic orbits.
+    double e; ///< Eccentricity
+    double i; ///< Inclination from the frame's xy-plane: rad
+    double periapsis; ///< Closest distance to the center: m
+    double apoapsis; ///< Farthest distance from the center: m.  Infinite if unbound.
+};
+
+/// @param r Position relative to the central body.
+/// @param v Velocity relative to the central body.
+/// @param mu The gravitational parameter, G times the central mass.
+/// @return The elements of the orbit that passes through r with velocity v.
+Elements elements(V3 const& r, V3 const& v, double mu);
+
+#endif // LOFT_LOFTLIB_ORBIT_HH_INCLUDED
@@ -0,0 +1,120 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "parallel.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+/// A worker's share of the indices.
+struct Share
+{
+    std::mutex mutex;
+    std::size_t begin{0};
+    std::size_t end{0};
+};
+
+/// @return True if an index was taken from the front of the share.
+bool take(Share& share, std::size_t& index)
+{
+    std::lock_guard lock(share.mutex);
+    if (share.begin == share.end)
+        return false;
+    index = share.begin++;
+    return true;
+}
+
+/// Move the upper half of the victim's remaining indices to the thief.
+/// @return True if anything was stolen.
+bool steal(Share& victim, Share& thief)
+{
+    std::size_t begin, end;
+    {
+        std::lock_guard lock(victim.mutex);
+        if (victim.begin == victim.end)
+            return false;
+        // Round down so that a single remaining index goes to the thief.
+        end = victim.end;
+        begin = victim.begin + (end - victim.begin)/2;
+        victim.end = begin;
+    }
+    std::lock_guard lock(thief.mutex);
+    thief.begin = begin;
+    thief.end = end;
+    return true;
+}
+}
+
+void parallel_for(std::size_t n, std::function<void(std::size_t)> const& fn,
+                  unsigned threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<std::size_t>(1, std::min<std::size_t>(threads, n));
+
+    std::vector<Share> shares(threads);
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        shares[t].begin = n*t/threads;
+        shares[t].end = n*(t + 1)/threads;
+    }
+
+    std::atomic<bool> stop{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto work = [&](std::size_t t) {
+        while (!stop)
+        {
+            std::size_t i;
+            if (!take(shares[t], i))
+            {
+                // Look for work in the other shares, nearest neighbor first.
+                auto stolen{false};
+                for (std::size_t k = 1; k < threads && !stolen; ++k)
+                    stolen = steal(shares[(t + k) % threads], shares[t]);
+                if (!stolen)
+                    return;
+                continue;
+            }
+            try
+            {
+                fn(i);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+                stop = true;
+            }
+        }
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 1; t < threads; ++t)
+            workers.emplace_back(work, t);
+        // The calling thread does its share too.
+        work(0);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
@@ -0,0 +1,31 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_PARALLEL_HH_INCLUDED
+#define LOFT_LOFTLIB_PARALLEL_HH_INCLUDED
+
+#include <cstddef>
+#include <functional>
+
+/// Call fn(i) for each i in [0, n) on a set of worker threads.  Each worker starts with an
+/// equal contiguous share of the indices.  A worker that runs out steals the upper half of
+/// another worker's remaining share so that long and short cases balance across the
+/// workers.  If any call throws, the first exception is rethrown after all workers have
+/// finished.
+/// @param threads The number of workers.  Zero means one per hardware thread.
+void parallel_for(std::size_t n, std::function<void(std::size_t)> const& fn,
+                  unsigned threads = 0);
+
+#endif // LOFT_LOFTLIB_PARALLEL_HH_INCLUDED
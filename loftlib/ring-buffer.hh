@@ -0,0 +1,78 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_RING_BUFFER_HH_INCLUDED
+#define LOFT_LOFTLIB_RING_BUFFER_HH_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/// A fixed-size queue from one producer thread to one consumer thread without locks.
+/// Neither thread ever waits: push() fails when the queue is full and pop() fails when
+/// it's empty.
+template <typename T>
+class Ring_Buffer
+{
+public:
+    /// @param capacity The number of values the queue can hold.  Rounded up to a power
+    /// of 2.
+    explicit Ring_Buffer(std::size_t capacity)
+    {
+        std::size_t size{1};
+        while (size < capacity)
+            size *= 2;
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+    /// Called by the producer.
+    /// @return False if the queue is full.
+    bool push(T const& value)
+    {
+        auto head{m_head.load(std::memory_order_relaxed)};
+        if (head - m_tail.load(std::memory_order_acquire) > m_mask)
+            return false;
+        m_slots[head & m_mask] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    /// Called by the consumer.
+    /// @return False if the queue is empty.
+    bool pop(T& value)
+    {
+        auto tail{m_tail.load(std::memory_order_relaxed)};
+        if (tail == m_head.load(std::memory_order_acquire))
+            return false;
+        value = m_slots[tail & m_mask];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    /// @return The number of values the queue can hold.
+    std::size_t capacity() const
+    {
+        return m_slots.size();
+    }
+
+private:
+    std::vector<T> m_slots;
+    std::size_t m_mask;
+    /// The count of values pushed.  Written by the producer.  Kept on its own cache line
+    /// so the threads don't contend.
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    /// The count of values popped.  Written by the consumer.
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
+
+#endif // LOFT_LOFTLIB_RING_BUFFER_HH_INCLUDED
@@ -14,9 +14,12 @@
 //  If not, see <http://www.gnu.org/licenses/>.
 
 #include "rocket.hh"
+#include "serialize.hh"
 #include "units.hh"
 
+#include <cmath>
 #include <numbers>
+#include <utility>
 
 using namespace std::numbers;
 
@@ -37,14 +40,20 @@ public:
     /// @return The impulse attainable from the actual amount of fuel consumed.
     double get_impulse(double volume);
     double volume() const { return m_depth*m_area; }
+    /// @return The impulse attainable from a unit volume of fuel.
+    double impulse_density() const { return m_impulse*m_density; }
+
+    virtual void save(std::ostream& os) const override;
+    virtual void restore(std::istream& is) override;
 
 private:
-    const double m_density;
-    const double m_radius;
-    const double m_area;
-    const double m_full_depth; ///< The initial depth of fuel.
+    // Not const so that they can be restored from a checkpoint.
+    double m_density;
+    double m_radius;
+    double m_area;
+    double m_full_depth; ///< The initial depth of fuel.
     double m_depth; ///< The current depth of fuel.
-    const double m_impulse;
+    double m_impulse;
 };
 
 Fuel::Fuel(double radius, double depth, double density, double impulse)
@@ -73,6 +82,20 @@ double Fuel::get_impulse(double volume)
     return m_impulse*m_density*dV;
 }
 
+void Fuel::save(std::ostream& os) const
+{
+    Body::save(os);
+    for (auto x : {m_density, m_radius, m_area, m_full_depth, m_depth, m_impulse})
+        serialize::write(os, x);
+}
+
+void Fuel::restore(std::istream& is)
+{
+    Body::restore(is);
+    for (auto* x : {&m_density, &m_radius, &m_area, &m_full_depth, &m_depth, &m_impulse})
+        serialize::read(is, *x);
+}
+
 
 /// A steerable, throttleable rocket engine.
 class Engine : public Body
@@ -85,6 +108,8 @@ public:
 
     /// @param frac The fraction of full throttle.
     void throttle(double frac);
+    /// @return The fraction of full throttle.
+    double throttle() const;
     /// Set the direction of engine thrust.
     /// @param v Rotate thrust from the z-direction about the rocket-frame axis and angle.
     void orient(V3 const& v);
@@ -93,6 +118,12 @@ public:
     /// @return The impulse vector to apply to the rocket.
     /// @param max_impulse The maximum impulse available from the fuel.
     V3 get_impulse(double max_impulse) const;
+    /// @return The impulse per unit time at full throttle.
+    /// @param impulse_density The impulse available from a unit volume of fuel.
+    double max_impulse(double impulse_density) const;
+
+    virtual void save(std::ostream& os) const override;
+    virtual void restore(std::istream& is) override;
 
 private:
     double m_fuel_rate;
@@ -112,6 +143,11 @@ void Engine::throttle(double k)
     m_throttle = k;
 }
 
+double Engine::throttle() const
+{
+    return m_throttle;
+}
+
 void Engine::orient(V3 const& v)
 {
     // The engine always produces thrust in its z-direction.
@@ -128,6 +164,25 @@ V3 Engine::get_impulse(double max_impulse) const
     return max_impulse*m_efficiency*rotate_out(Vz);
 }
 
+double Engine::max_impulse(double impulse_density) const
+{
+    return impulse_density*m_fuel_rate*m_efficiency;
+}
+
+void Engine::save(std::ostream& os) const
+{
+    Body::save(os);
+    for (auto x : {m_fuel_rate, m_efficiency, m_throttle})
+        serialize::write(os, x);
+}
+
+void Engine::restore(std::istream& is)
+{
+    Body::restore(is);
+    for (auto* x : {&m_fuel_rate, &m_efficiency, &m_throttle})
+        serialize::read(is, *x);
+}
+
 
 Rocket::Rocket(double shell_mass, double engine_mass, double radius, double length,
                double fuel_density, double spec_impulse, double fuel_rate,
@@ -140,33 +195,152 @@ Rocket::Rocket(double shell_mass, double engine_mass, double radius, double leng
 {
     capture(m_engine);
     capture(m_fuel);
-    // Set position relative to the rocket after capturing.
+    // Set positions relative to the rocket after capturing.  The tank is full, so the
+    // fuel is centered.
     m_engine->set_r(-length/2*Vz);
+    m_fuel->set_r(V0);
     set_orientation(orientation);
 }
 
+void Rocket::add_stage(std::shared_ptr<Rocket> stage)
+{
+    capture(stage);
+}
+
+std::shared_ptr<Rocket> Rocket::stage()
+{
+    auto stage{lowest_stage()};
+    if (!stage)
+        return nullptr;
+    auto& spent{stage->active_stage()};
+    auto throttle{spent.m_engine->throttle()};
+    release(stage);
+    spent.m_engine->throttle(0.0);
+    active_stage().m_engine->throttle(throttle);
+    return stage;
+}
+
+std::size_t Rocket::stages() const
+{
+    std::size_t n{0};
+    for (auto const& part : parts())
+        if (auto const* stage{dynamic_cast<Rocket const*>(part.get())})
+            n += 1 + stage->stages();
+    return n;
+}
+
+std::shared_ptr<Rocket> Rocket::lowest_stage() const
+{
+    // Stages are the rockets that this one has captured, in the order they were added.
+    for (auto it{parts().rbegin()}; it != parts().rend(); ++it)
+        if (auto stage{std::dynamic_pointer_cast<Rocket>(*it)})
+            return stage;
+    return nullptr;
+}
+
+Rocket& Rocket::active_stage()
+{
+    auto stage{lowest_stage()};
+    return stage ? stage->active_stage() : *this;
+}
+
+Rocket const& Rocket::active_stage() const
+{
+    auto stage{lowest_stage()};
+    return stage ? std::as_const(*stage).active_stage() : *this;
+}
+
 void Rocket::throttle(double frac)
 {
-    m_engine->throttle(frac);
+    active_stage().m_engine->throttle(frac);
 }
 
 void Rocket::orient_thrust(V3 const& v)
 {
-    m_engine->orient(v);
+    active_stage().m_engine->orient(v);
+}
+
+void Rocket::point_thrust(V3 const& direction)
+{
+    // Rotate the engine's z-axis onto the direction in the active stage's frame.
+    auto& stage{active_stage()};
+    auto d{unit(stage.rotate_in(direction))};
+    auto c{dot(Vz, d)};
+    if (c >= 1.0)
+        stage.m_engine->orient(V0);
+    else if (c <= -1.0)
+        stage.m_engine->orient(pi*Vx);
+    else
+        stage.m_engine->orient(std::acos(c)*unit(cross(Vz, d)));
 }
 
 double Rocket::fuel_volume() const
 {
-    return m_fuel->volume();
+    return active_stage().m_fuel->volume();
+}
+
+V3 Rocket::thrust() const
+{
+    auto const& stage{active_stage()};
+    if (stage.m_fuel->volume() <= 0.0)
+        return V0;
+    return stage.m_engine->get_impulse(stage.m_fuel->impulse_density()
+                                       *stage.m_engine->consumed(1.0));
+}
+
+double Rocket::max_thrust() const
+{
+    auto const& stage{active_stage()};
+    if (stage.m_fuel->volume() <= 0.0)
+        return 0.0;
+    return stage.m_engine->max_impulse(stage.m_fuel->impulse_density());
 }
 
 void Rocket::step(double time)
 {
+    auto shift{V0};
     if (is_free())
     {
-        auto volume{m_engine->consumed(time)};
-        auto imp{m_engine->get_impulse(m_fuel->get_impulse(volume))};
-        impulse(imp, transform_out(m_engine->r_cm()));
+        // The velocity change follows the rocket equation, Δv = vₑ ln(m₀/m₁), so it
+        // doesn't depend on how the burn is divided into steps.
+        auto& stage{active_stage()};
+        auto volume{stage.m_engine->consumed(time)};
+        auto available{stage.m_fuel->volume()};
+        auto m0{m()};
+        auto imp{stage.m_engine->get_impulse(stage.m_fuel->get_impulse(volume))};
+        auto m1{m()};
+        if (m1 < m0)
+        {
+            // The expelled momentum turns the rocket.  The rest of the velocity change is
+            // at the center of mass.
+            auto x{(m0 - m1)/m1};
+            auto ln{std::log1p(x)};
+            impulse(imp, stage.transform_out(stage.m_engine->r_cm()));
+            Body::impulse(imp*(ln/x - 1.0));
+            // Thrust acts throughout the burn, which ends early if the tank runs dry.
+            // With the mass falling linearly from m₀ to m₁ over the burn time t, the
+            // thrust moves the rocket vₑ t (1 - ln(m₀/m₁) m₁/(m₀ - m₁)) by the end of the
+            // burn.  Body::step() moves it by the full Δv over the whole step, so take
+            // back the difference.
+            auto burn{time*std::min(1.0, available/volume)};
+            shift = imp/(m0 - m1)*burn*(1.0 - ln/x - ln);
+        }
     }
     Body::step(time);
+    if (shift != V0)
+        displace(shift);
+}
+
+void Rocket::save(std::ostream& os) const
+{
+    Body::save(os);
+    m_engine->save(os);
+    m_fuel->save(os);
+}
+
+void Rocket::restore(std::istream& is)
+{
+    Body::restore(is);
+    m_engine->restore(is);
+    m_fuel->restore(is);
 }
@@ -18,13 +18,15 @@
 
 #include "body.hh"
 
+#include <cstddef>
 #include <memory>
 
 class Engine;
 class Fuel;
 class V3;
 
-/// A liquid-fueled rocket with orientable engine.
+/// A liquid-fueled rocket with orientable engine.  A rocket can carry lower stages, each
+/// a rocket of its own.  The lowest stage fires until it's jettisoned.
 class Rocket : public Body
 {
 public:
@@ -42,6 +44,18 @@ public:
            V3 const& position, M3 const& orientation);
     ~Rocket() = default;
 
+    /// Attach a stage below the current lowest one.  The stage is captured at its current
+    /// position and orientation, and its engine fires in place of the rocket's until it's
+    /// jettisoned.  Add the stage to the universe too if it should be saved in
+    /// checkpoints and flown after it's jettisoned.
+    void add_stage(std::shared_ptr<Rocket> stage);
+    /// Jettison the lowest stage.  Its engine is shut off and the next stage's engine
+    /// takes over at the same throttle setting.
+    /// @return The released stage, or nullptr if there are no more stages.
+    std::shared_ptr<Rocket> stage();
+    /// @return The number of stages below this rocket.
+    std::size_t stages() const;
+
     /// Set the engine throttle.
     /// @param frac Fraction of full throttle.
     void throttle(double frac);
@@ -50,11 +64,28 @@ public:
     /// amount equal to the length of v in radians.  Call with V0 to set the thrust
     /// direction to the rocket's z-axis.
     void orient_thrust(V3 const& v);
-    /// @return The volume of fuel left in the tank.
+    /// Turn the engine so that it thrusts in the given absolute direction.
+    void point_thrust(V3 const& direction);
+    /// @return The volume of fuel left in the active stage's tank.
     double fuel_volume() const;
+    /// @return The current thrust force in absolute coordinates.  Zero if out of fuel.
+    V3 thrust() const;
+    /// @return The magnitude of the thrust at full throttle.  Zero if out of fuel.
+    double max_thrust() const;
     virtual void step(double time) override;
 
+    /// Save and restore the engine and fuel along with the rocket.
+    virtual void save(std::ostream& os) const override;
+    virtual void restore(std::istream& is) override;
+
 private:
+    /// @return The lowest stage, or nullptr if there are none.
+    std::shared_ptr<Rocket> lowest_stage() const;
+    /// @return The stage whose engine is firing: the lowest one, or this rocket if there
+    /// are none.
+    Rocket& active_stage();
+    Rocket const& active_stage() const;
+
     std::shared_ptr<Engine> m_engine;
     std::shared_ptr<Fuel> m_fuel;
 };
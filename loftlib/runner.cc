@@ -0,0 +1,89 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "runner.hh"
+#include "universe.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+Runner::Runner(Universe& universe, double step)
+    : m_universe(universe),
+      m_step(step)
+{
+    assert(step > 0.0);
+}
+
+void Runner::observe(Observer observer)
+{
+    m_observers.push_back(observer);
+}
+
+void Runner::set_pacing(double warp)
+{
+    m_warp = warp;
+}
+
+double Runner::step() const
+{
+    return m_step;
+}
+
+std::size_t Runner::run(double duration)
+{
+    using Clock = std::chrono::steady_clock;
+    auto start{Clock::now()};
+    auto n{static_cast<std::size_t>(std::max(0.0, std::round(duration/m_step)))};
+    m_stop = false;
+    std::size_t i = 0;
+    while (i < n && !m_stop)
+    {
+        take_step();
+        ++i;
+        if (m_warp > 0.0)
+            std::this_thread::sleep_until(
+                start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(i*m_step/m_warp)));
+    }
+    return i;
+}
+
+std::size_t Runner::advance(double duration)
+{
+    m_pending += duration;
+    std::size_t n = 0;
+    while (m_pending >= m_step)
+    {
+        take_step();
+        m_pending -= m_step;
+        ++n;
+    }
+    return n;
+}
+
+void Runner::stop()
+{
+    m_stop = true;
+}
+
+void Runner::take_step()
+{
+    m_universe.step(m_step);
+    for (auto& observer : m_observers)
+        observer(m_universe);
+}
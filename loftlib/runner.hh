@@ -0,0 +1,74 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_RUNNER_HH_INCLUDED
+#define LOFT_LOFTLIB_RUNNER_HH_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class Universe;
+
+/// Advances a universe with a fixed time step, independent of any display.  The same
+/// scenario run with the same step gives the same result no matter how fast the CPU is or
+/// how the steps are grouped.
+class Runner
+{
+public:
+    /// Called after every step.
+    using Observer = std::function<void(Universe&)>;
+
+    /// @param universe The universe to advance.  It must outlive the runner.
+    /// @param step The fixed time step.
+    Runner(Universe& universe, double step);
+
+    /// Add a function to call after each step, e.g. to fire engines or record state.
+    void observe(Observer observer);
+    /// Set the ratio of simulated time to wall-clock time for run().
+    /// @param warp Simulated seconds per real second.  Zero means as fast as possible.
+    void set_pacing(double warp);
+    /// @return The fixed time step.
+    double step() const;
+
+    /// Take as many steps as it takes to cover the given span of simulated time.  The
+    /// last step is not shortened, so the span is rounded to a whole number of steps.
+    /// Pacing is applied if set.  May be cut short by stop().
+    /// @return The number of steps taken.
+    std::size_t run(double duration);
+    /// Take the whole steps that fit in the given span plus any time left over from
+    /// earlier calls.  Useful for loops that are driven by a frame clock.  Pacing is not
+    /// applied.
+    /// @return The number of steps taken.
+    std::size_t advance(double duration);
+    /// Make run() return after the current step.  May be called from an observer or from
+    /// another thread.
+    void stop();
+
+private:
+    /// Take one step and notify observers.
+    void take_step();
+
+    Universe& m_universe;
+    double m_step;
+    double m_warp{0.0};
+    /// Simulated time not yet covered by advance().
+    double m_pending{0.0};
+    std::atomic<bool> m_stop{false};
+    std::vector<Observer> m_observers;
+};
+
+#endif // LOFT_LOFTLIB_RUNNER_HH_INCLUDED
@@ -0,0 +1,551 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "atmosphere.hh"
+#include "harmonics.hh"
+#include "rocket.hh"
+#include "scenario.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/// Splits the text of a scenario into lines and words.  Everything is a view into the
+/// text, so nothing is copied.
+class Reader
+{
+public:
+    explicit Reader(std::string_view text) : m_text(text) {}
+
+    /// Move to the next line that has something on it.
+    /// @return False at the end of the text.
+    bool next_line()
+    {
+        while (m_pos < m_text.size())
+        {
+            auto end{m_text.find('\n', m_pos)};
+            if (end == std::string_view::npos)
+                end = m_text.size();
+            m_line = m_text.substr(m_pos, end - m_pos);
+            m_pos = end + 1;
+            ++m_number;
+            if (auto hash{m_line.find('#')}; hash != std::string_view::npos)
+                m_line = m_line.substr(0, hash);
+            skip_space();
+            if (!m_line.empty())
+                return true;
+        }
+        return false;
+    }
+    /// @return The next word on the line, or an empty view at the end of the line.
+    std::string_view word()
+    {
+        skip_space();
+        std::size_t end{0};
+        while (end < m_line.size() && !is_space(m_line[end]))
+            ++end;
+        auto w{m_line.substr(0, end)};
+        m_line.remove_prefix(end);
+        return w;
+    }
+    std::size_t line_number() const
+    {
+        return m_number;
+    }
+
+private:
+    void skip_space()
+    {
+        std::size_t begin{0};
+        while (begin < m_line.size() && is_space(m_line[begin]))
+            ++begin;
+        m_line.remove_prefix(begin);
+    }
+
+    std::string_view m_text;
+    std::size_t m_pos{0};
+    std::string_view m_line;
+    std::size_t m_number{0};
+};
+
+/// Parse a number with an optional unit suffix or in degrees:minutes:seconds.
+bool parse_number(std::string_view s, double& x)
+{
+    auto const* end{s.data() + s.size()};
+    auto [p, ec] = std::from_chars(s.data(), end, x);
+    if (ec != std::errc())
+        return false;
+    std::string_view rest(p, end - p);
+    if (rest.empty())
+        return true;
+    if (rest == "deg")
+        x = units::deg(x);
+    else if (rest == "day")
+        x = units::day(x);
+    else if (rest[0] == ':')
+    {
+        double minutes;
+        auto [p2, ec2] = std::from_chars(p + 1, end, minutes);
+        if (ec2 != std::errc() || p2 == end || *p2 != ':')
+            return false;
+        double seconds;
+        auto [p3, ec3] = std::from_chars(p2 + 1, end, seconds);
+        if (ec3 != std::errc() || p3 != end)
+            return false;
+        x = units::dms(x, minutes, seconds);
+    }
+    else
+        return false;
+    return true;
+}
+
+/// Parse X,Y,Z.
+bool parse_vector(std::string_view s, V3& v)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        auto comma{i < 2 ? s.find(',') : s.size()};
+        if (comma == std::string_view::npos || !parse_number(s.substr(0, comma), v[i]))
+            return false;
+        s.remove_prefix(std::min(comma + 1, s.size()));
+    }
+    return true;
+}
+
+/// Who is captured by whom, followed while parsing so that captures and releases can be
+/// checked before they're made.
+class Assembly
+{
+public:
+    /// Record a capture.  Stages are captured before anything else, so they come before
+    /// the other parts of their rocket.
+    /// @return A message saying why the capture can't be made, or an empty view.
+    std::string_view capture(Body const* parent, Body const* child, bool stage = false)
+    {
+        if (parent == child)
+            return "can't capture itself";
+        if (m_parent.contains(child))
+            return "already captured";
+        for (auto p{parent}; p; p = this->parent(p))
+            if (p == child)
+                return "can't capture a parent";
+        m_parent[child] = parent;
+        auto& parts{m_parts[parent]};
+        if (stage)
+            parts.insert(parts.begin() + m_stages[parent]++, child);
+        else
+            parts.push_back(child);
+        return {};
+    }
+    /// Record a release.
+    /// @return A message saying why the release can't be made, or an empty view.
+    std::string_view release(Body const* parent, Body const* child)
+    {
+        if (this->parent(child) != parent)
+            return "not captured";
+        m_parent.erase(child);
+        std::erase(m_parts[parent], child);
+        return {};
+    }
+    /// Record the release of a rocket's lowest stage, if it has one.  See
+    /// Rocket::lowest_stage().
+    void stage(Body const* rocket)
+    {
+        auto const& parts{m_parts[rocket]};
+        auto it{std::find_if(parts.rbegin(), parts.rend(), [](Body const* part) {
+            return dynamic_cast<Rocket const*>(part);
+        })};
+        if (it != parts.rend())
+            release(rocket, *it);
+    }
+
+private:
+    Body const* parent(Body const* child) const
+    {
+        auto it{m_parent.find(child)};
+        return it == m_parent.end() ? nullptr : it->second;
+    }
+
+    std::unordered_map<Body const*, Body const*> m_parent;
+    std::unordered_map<Body const*, std::vector<Body const*>> m_parts;
+    /// The number of stages at the front of each rocket's parts.
+    std::unordered_map<Body const*, std::size_t> m_stages;
+};
+
+/// An event from an "at" line.
+struct Event
+{
+    double time;
+    Universe::Action action;
+    std::size_t line;
+    /// Record the event's capture or release, if it has one.
+    /// @return A message saying why it can't be made, or an empty view.
+    std::function<std::string_view(Assembly&)> assemble;
+};
+
+/// The key=value arguments of a body line.
+struct Properties
+{
+    double mass{0.0};
+    V3 inertia{1.0, 1.0, 1.0};
+    double radius{0.0};
+    double period{0.0};
+    double shell_mass{0.0};
+    double engine_mass{0.0};
+    double length{0.0};
+    double fuel_density{0.0};
+    double specific_impulse{0.0};
+    double fuel_rate{0.0};
+    double throttle{0.0};
+    double atmosphere{0.0};
+    double drag_area{0.0};
+    double gravity_degree{0.0};
+    double gravity_order{0.0};
+    V3 r{V0};
+    V3 v{V0};
+    V3 orientation{V0};
+    V3 omega{V0};
+    std::string_view on;
+    double lat{0.0};
+    double lon{0.0};
+    double alt{0.0};
+};
+
+/// Set a property from a key=value argument.
+/// @return False if the key is unknown or the value can't be parsed.
+bool set_property(Properties& p, std::string_view arg)
+{
+    auto eq{arg.find('=')};
+    if (eq == std::string_view::npos)
+        return false;
+    auto key{arg.substr(0, eq)};
+    auto value{arg.substr(eq + 1)};
+    if (key == "on")
+    {
+        p.on = value;
+        return !value.empty();
+    }
+
+    using Scalar = std::pair<std::string_view, double Properties::*>;
+    static Scalar const scalars[]{
+        {"mass", &Properties::mass},
+        {"radius", &Properties::radius},
+        {"period", &Properties::period},
+        {"shell_mass", &Properties::shell_mass},
+        {"engine_mass", &Properties::engine_mass},
+        {"length", &Properties::length},
+        {"fuel_density", &Properties::fuel_density},
+        {"specific_impulse", &Properties::specific_impulse},
+        {"fuel_rate", &Properties::fuel_rate},
+        {"throttle", &Properties::throttle},
+        {"atmosphere", &Properties::atmosphere},
+        {"drag_area", &Properties::drag_area},
+        {"gravity_degree", &Properties::gravity_degree},
+        {"gravity_order", &Properties::gravity_order},
+        {"lat", &Properties::lat},
+        {"lon", &Properties::lon},
+        {"alt", &Properties::alt},
+    };
+    for (auto const& [name, member] : scalars)
+        if (key == name)
+            return parse_number(value, p.*member);
+
+    using Vector = std::pair<std::string_view, V3 Properties::*>;
+    static Vector const vectors[]{
+        {"inertia", &Properties::inertia},
+        {"r", &Properties::r},
+        {"v", &Properties::v},
+        {"orientation", &Properties::orientation},
+        {"omega", &Properties::omega},
+    };
+    for (auto const& [name, member] : vectors)
+        if (key == name)
+            return parse_vector(value, p.*member);
+    return false;
+}
+}
+
+std::shared_ptr<Scenario> Scenario::load(std::string const& path, std::string* error)
+{
+    // Map the file rather than copying it.
+    auto fd{::open(path.c_str(), O_RDONLY)};
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        if (error)
+            *error = "can't read " + path;
+        return nullptr;
+    }
+    auto size{static_cast<std::size_t>(st.st_size)};
+    if (size == 0)
+    {
+        ::close(fd);
+        return parse({}, error);
+    }
+    auto* data{::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        if (error)
+            *error = "can't read " + path;
+        return nullptr;
+    }
+    auto scenario{parse({static_cast<char const*>(data), size}, error)};
+    ::munmap(data, size);
+    return scenario;
+}
+
+std::shared_ptr<Scenario> Scenario::parse(std::string_view text, std::string* error)
+{
+    auto scenario{std::make_shared<Scenario>()};
+    bool collisions{true};
+    std::vector<std::pair<std::shared_ptr<Body>, std::shared_ptr<Body>>> captures;
+    std::vector<std::pair<std::shared_ptr<Rocket>, std::shared_ptr<Rocket>>> stages;
+    std::vector<Event> events;
+    Assembly assembly;
+
+    Reader reader(text);
+    auto fail_at{[&](std::size_t line, std::string_view message) {
+        if (error)
+        {
+            std::ostringstream os;
+            os << "line " << line << ": " << message;
+            *error = os.str();
+        }
+        return nullptr;
+    }};
+    auto fail{[&](std::string const& message) {
+        return fail_at(reader.line_number(), message);
+    }};
+    auto find{[&](std::string_view name) {
+        auto it{scenario->m_names.find(std::string(name))};
+        return it == scenario->m_names.end() ? nullptr : it->second;
+    }};
+
+    while (reader.next_line())
+    {
+        auto command{reader.word()};
+        if (command == "universe")
+        {
+            if (scenario->m_universe)
+                return fail("universe must come before bodies");
+            for (auto arg{reader.word()}; !arg.empty(); arg = reader.word())
+            {
+                double x;
+                if (!arg.starts_with("collisions=") || !parse_number(arg.substr(11), x))
+                    return fail("bad argument: " + std::string(arg));
+                collisions = x != 0.0;
+            }
+        }
+        else if (command == "world" || command == "body" || command == "rocket")
+        {
+            auto name{reader.word()};
+            if (name.empty())
+                return fail("missing name");
+            Properties p;
+            for (auto arg{reader.word()}; !arg.empty(); arg = reader.word())
+                if (!set_property(p, arg))
+                    return fail("bad argument: " + std::string(arg));
+
+            std::shared_ptr<Body> parent;
+            auto r{p.r};
+            auto orientation{rot(M1, p.orientation)};
+            if (!p.on.empty())
+            {
+                auto world{std::dynamic_pointer_cast<World>(find(p.on))};
+                if (!world)
+                    return fail("no world named " + std::string(p.on));
+                std::tie(r, orientation) = world->locate(p.lat, p.lon, p.alt);
+                parent = world;
+            }
+
+            std::shared_ptr<Body> body;
+            if (command == "world")
+            {
+                auto world{std::make_shared<World>(p.mass, p.radius, r, p.v, orientation,
+                                                   p.period)};
+                if (p.atmosphere != 0.0)
+                    world->set_atmosphere(Atmosphere::standard());
+                if (p.gravity_degree >= 2.0)
+                    world->set_harmonics(Harmonics::earth(),
+                                         static_cast<std::size_t>(p.gravity_degree),
+                                         static_cast<std::size_t>(p.gravity_order));
+                body = world;
+            }
+            else if (command == "body")
+                body = std::make_shared<Body>(p.mass,
+                                              M3(p.inertia.x*Vx, p.inertia.y*Vy,
+                                                 p.inertia.z*Vz),
+                                              r, p.v, orientation, p.omega);
+            else
+            {
+                auto rocket{std::make_shared<Rocket>(p.shell_mass, p.engine_mass, p.radius,
+                                                     p.length, p.fuel_density,
+                                                     p.specific_impulse, p.fuel_rate,
+                                                     r, orientation)};
+                rocket->throttle(p.throttle);
+                body = rocket;
+            }
+            body->set_drag_area(p.drag_area);
+            if (!scenario->m_universe)
+                scenario->m_universe = std::make_shared<Universe>(collisions);
+            if (parent)
+            {
+                // The body is new, so it can't be captured already.
+                assembly.capture(parent.get(), body.get());
+                captures.emplace_back(parent, body);
+            }
+            if (name != "-" && !scenario->m_names.emplace(name, body).second)
+                return fail("duplicate name: " + std::string(name));
+            scenario->m_universe->add(std::move(body));
+        }
+        else if (command == "capture")
+        {
+            auto parent{find(reader.word())};
+            auto child{find(reader.word())};
+            if (!parent || !child)
+                return fail("capture needs 2 bodies");
+            if (auto problem{assembly.capture(parent.get(), child.get())}; !problem.empty())
+                return fail(std::string(problem));
+            captures.emplace_back(parent, child);
+        }
+        else if (command == "stage")
+        {
+            auto rocket{std::dynamic_pointer_cast<Rocket>(find(reader.word()))};
+            auto stage{std::dynamic_pointer_cast<Rocket>(find(reader.word()))};
+            if (!rocket || !stage)
+                return fail("stage needs 2 rockets");
+            if (auto problem{assembly.capture(rocket.get(), stage.get(), true)};
+                !problem.empty())
+                return fail(std::string(problem));
+            stages.emplace_back(rocket, stage);
+        }
+        else if (command == "at")
+        {
+            double time;
+            if (!parse_number(reader.word(), time))
+                return fail("bad time");
+            auto action{reader.word()};
+            Event event{time, {}, reader.line_number(), {}};
+            if (action == "release" || action == "capture")
+            {
+                auto parent{find(reader.word())};
+                auto child{find(reader.word())};
+                if (!parent || !child)
+                    return fail(std::string(action) + " needs 2 bodies");
+                if (action == "release")
+                {
+                    event.action = [parent, child](Universe&) { parent->release(child); };
+                    event.assemble = [p = parent.get(), c = child.get()](Assembly& a) {
+                        return a.release(p, c);
+                    };
+                }
+                else
+                {
+                    event.action = [parent, child](Universe&) { parent->capture(child); };
+                    event.assemble = [p = parent.get(), c = child.get()](Assembly& a) {
+                        return a.capture(p, c);
+                    };
+                }
+            }
+            else if (action == "throttle" || action == "orient")
+            {
+                auto rocket{std::dynamic_pointer_cast<Rocket>(find(reader.word()))};
+                if (!rocket)
+                    return fail(std::string(action) + " needs a rocket");
+                auto value{reader.word()};
+                double x;
+                V3 v;
+                if (action == "throttle" && parse_number(value, x))
+                    event.action = [rocket, x](Universe&) { rocket->throttle(x); };
+                else if (action == "orient" && parse_vector(value, v))
+                    event.action = [rocket, v](Universe&) { rocket->orient_thrust(v); };
+                else
+                    return fail("bad value: " + std::string(value));
+            }
+            else if (action == "stage")
+            {
+                auto rocket{std::dynamic_pointer_cast<Rocket>(find(reader.word()))};
+                if (!rocket)
+                    return fail("stage needs a rocket");
+                event.action = [rocket](Universe&) { rocket->stage(); };
+                event.assemble = [r = rocket.get()](Assembly& a) {
+                    a.stage(r);
+                    return std::string_view{};
+                };
+            }
+            else
+                return fail("unknown action: " + std::string(action));
+            events.push_back(std::move(event));
+        }
+        else
+            return fail("unknown command: " + std::string(command));
+
+        if (!reader.word().empty())
+            return fail("too many arguments");
+    }
+
+    // Check the events' captures and releases in the order they'll happen.  Actions at
+    // the same time run in the order they were scheduled.
+    std::stable_sort(events.begin(), events.end(), [](auto const& e1, auto const& e2) {
+        return e1.time < e2.time;
+    });
+    for (auto const& event : events)
+        if (event.assemble)
+            if (auto problem{event.assemble(assembly)}; !problem.empty())
+                return fail_at(event.line, problem);
+
+    if (!scenario->m_universe)
+        scenario->m_universe = std::make_shared<Universe>(collisions);
+    // Stack the stages before putting the rockets on the pad.
+    for (auto& [rocket, stage] : stages)
+        rocket->add_stage(stage);
+    for (auto& [parent, child] : captures)
+        parent->capture(child);
+    for (auto& event : events)
+        scenario->m_universe->schedule(event.time, std::move(event.action));
+    return scenario;
+}
+
+std::shared_ptr<Universe> Scenario::universe() const
+{
+    return m_universe;
+}
+
+std::shared_ptr<Body> Scenario::body(std::string const& name) const
+{
+    auto it{m_names.find(name)};
+    return it == m_names.end() ? nullptr : it->second;
+}
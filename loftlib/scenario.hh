@@ -0,0 +1,88 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_SCENARIO_HH_INCLUDED
+#define LOFT_LOFTLIB_SCENARIO_HH_INCLUDED
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class Body;
+class Universe;
+
+// A scenario file describes the initial state of a universe and the events that change
+// it.  Each line is a command followed by space-separated arguments.  Everything after
+// '#' is ignored.
+//
+//   universe collisions=1
+//   world NAME mass= radius= period= r= v= orientation= atmosphere=
+//         gravity_degree= gravity_order=
+//   body NAME mass= inertia= r= v= orientation= omega=
+//   rocket NAME shell_mass= engine_mass= radius= length= fuel_density=
+//          specific_impulse= fuel_rate= throttle= r= orientation=
+//   capture PARENT CHILD
+//   stage ROCKET LOWER
+//   at TIME release PARENT CHILD
+//   at TIME capture PARENT CHILD
+//   at TIME throttle ROCKET FRACTION
+//   at TIME orient ROCKET X,Y,Z
+//   at TIME stage ROCKET
+//
+// Bodies, worlds, and rockets also take on=WORLD lat= lon= alt= to start on a world's
+// surface, captured by it, and drag_area= for drag in atmospheres.  atmosphere=1 gives
+// a world the standard atmosphere.  gravity_degree= of 2 or more gives a world the
+// Earth's gravity field through that degree, and gravity_order= limits the order of its
+// terms.  Omitted values are zero, except for unit inertia.  A world with no period=
+// doesn't rotate.
+// A name of "-" leaves the body unnamed.  Vectors are written X,Y,Z.  Orientations and
+// thrust directions are rotation vectors: the axis scaled by the angle.  Numbers are in
+// internal units (m, kg, s, rad) unless suffixed with "deg" or "day", or written as
+// degrees:minutes:seconds.  "stage" stacks a lower stage under a rocket, and the "stage"
+// event jettisons the lowest one.  Events are scheduled on the universe, so they happen
+// at exactly their time.  A body can't capture itself or one of its parents, and can
+// only be captured by one parent at a time, counting the captures and releases of
+// earlier events.
+
+/// A universe built from a scenario file.
+class Scenario
+{
+public:
+    /// Build a scenario from a file.
+    /// @param error Set to a message that gives the line number if loading fails.
+    /// @return The scenario, or nullptr if the file can't be read or has errors.
+    static std::shared_ptr<Scenario> load(std::string const& path,
+                                          std::string* error = nullptr);
+    /// Build a scenario from the text of a scenario file.
+    static std::shared_ptr<Scenario> parse(std::string_view text,
+                                           std::string* error = nullptr);
+
+    /// @return The universe in its initial state.
+    std::shared_ptr<Universe> universe() const;
+    /// @return The body with the given name, or nullptr if there isn't one.
+    std::shared_ptr<Body> body(std::string const& name) const;
+    /// @return The body with the given name if it has the requested type.
+    template <typename T> std::shared_ptr<T> get(std::string const& name) const
+    {
+        return std::dynamic_pointer_cast<T>(body(name));
+    }
+
+private:
+    std::shared_ptr<Universe> m_universe;
+    std::unordered_map<std::string, std::shared_ptr<Body>> m_names;
+};
+
+#endif // LOFT_LOFTLIB_SCENARIO_HH_INCLUDED
@@ -0,0 +1,119 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "script.hh"
+#include "universe.hh"
+
+#include <utility>
+
+namespace
+{
+/// A universe action that resumes a suspended script.  It owns the script's frame until
+/// then: if the universe drops the action without running it, the frame is destroyed.
+class Resume
+{
+public:
+    explicit Resume(Script::Handle handle)
+        : m_frame(std::make_shared<Frame>(handle))
+    {
+    }
+
+    void operator()(Universe&) const
+    {
+        // The script may finish and free its frame, or be suspended again and owned by
+        // a new action.
+        auto handle{std::exchange(m_frame->handle, {})};
+        try
+        {
+            handle.resume();
+        }
+        catch (...)
+        {
+            // An exception escaped the script.  It's stopped at its final suspend point.
+            handle.destroy();
+            throw;
+        }
+    }
+
+private:
+    struct Frame
+    {
+        explicit Frame(Script::Handle h) : handle(h) {}
+        ~Frame()
+        {
+            if (handle)
+                handle.destroy();
+        }
+        Script::Handle handle;
+    };
+    std::shared_ptr<Frame> m_frame;
+};
+}
+
+Script Script::promise_type::get_return_object()
+{
+    // Start at the beginning of the next step.
+    universe.schedule(universe.time(), Resume(Handle::from_promise(*this)));
+    return Script(state);
+}
+
+void Script::promise_type::return_void()
+{
+    state->done = true;
+}
+
+void Script::promise_type::unhandled_exception()
+{
+    state->done = true;
+    throw;
+}
+
+Script::Script(std::shared_ptr<State> state)
+    : m_state(state)
+{
+}
+
+bool Script::done() const
+{
+    return m_state->done;
+}
+
+bool After::await_ready() const
+{
+    return time <= 0.0;
+}
+
+void After::await_suspend(Script::Handle handle) const
+{
+    auto& universe{handle.promise().universe};
+    universe.schedule(universe.time() + time, Resume(handle));
+}
+
+bool Until::await_ready() const
+{
+    return condition();
+}
+
+void Until::await_suspend(Script::Handle handle) const
+{
+    handle.promise().universe.watch([condition = condition](Universe const&) {
+        return condition();
+    }, Resume(handle));
+}
+
+After after(double time)
+{
+    return {time};
+}
@@ -0,0 +1,121 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_SCRIPT_HH_INCLUDED
+#define LOFT_LOFTLIB_SCRIPT_HH_INCLUDED
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+class Universe;
+
+/// A control program written as a coroutine.  A script is a function that returns Script
+/// and takes the universe as its first parameter.  It waits with co_await after() or
+/// co_await until(), and the universe resumes it when the time comes.  Scripts don't
+/// cost anything while they wait for a time, and only their condition is checked while
+/// they wait for one.
+///
+///     Script ascent(Universe& u, std::shared_ptr<World> earth, std::shared_ptr<Rocket> r)
+///     {
+///         co_await after(1.0);
+///         earth->release(r);
+///         co_await until([&] { return altitude(*earth, *r) > 1e4; });
+///         r->orient_thrust(-2e-5*Vy);
+///     }
+///
+/// The script starts at the beginning of the universe's next step.  It runs until it
+/// finishes whether or not the returned Script is kept.  If the universe is destroyed
+/// first, the script is destroyed without being resumed.  Exceptions that escape a
+/// script are thrown from Universe::step().
+///
+/// GCC 12 destroys temporaries in a co_await expression twice if they have destructors.
+/// A condition that captures by value, e.g. a shared_ptr, must be made a named variable
+/// before it's passed to until().  Passing it as a temporary doesn't compile.
+class Script
+{
+public:
+    struct State
+    {
+        bool done{false};
+    };
+
+    struct promise_type
+    {
+        template <typename... Args>
+        promise_type(Universe& universe, Args const&...)
+            : universe(universe)
+        {
+        }
+
+        Script get_return_object();
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void();
+        void unhandled_exception();
+
+        Universe& universe;
+        std::shared_ptr<State> state{std::make_shared<State>()};
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    /// @return True if the script has finished.
+    bool done() const;
+
+private:
+    explicit Script(std::shared_ptr<State> state);
+
+    std::shared_ptr<State> m_state;
+};
+
+/// Suspends a script for a span of simulated time.
+struct After
+{
+    double time;
+
+    bool await_ready() const;
+    void await_suspend(Script::Handle handle) const;
+    void await_resume() const {}
+};
+
+/// Suspends a script until a condition is met.
+struct Until
+{
+    std::function<bool()> condition;
+
+    bool await_ready() const;
+    void await_suspend(Script::Handle handle) const;
+    void await_resume() const {}
+};
+
+/// @return An awaitable that resumes the script at exactly the given time from now.
+After after(double time);
+/// @return An awaitable that resumes the script after the first step that ends with the
+/// condition true.  Doesn't wait if it's true already.
+template <typename F>
+Until until(F&& condition)
+    requires std::is_lvalue_reference_v<F>
+             || std::is_trivially_destructible_v<std::remove_cvref_t<F>>
+{
+    return {std::forward<F>(condition)};
+}
+/// A temporary condition with a destructor would be destroyed twice.  See Script.
+template <typename F>
+Until until(F&& condition) = delete;
+
+#endif // LOFT_LOFTLIB_SCRIPT_HH_INCLUDED
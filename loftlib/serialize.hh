@@ -0,0 +1,43 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_SERIALIZE_HH_INCLUDED
+#define LOFT_LOFTLIB_SERIALIZE_HH_INCLUDED
+
+#include <iostream>
+#include <type_traits>
+
+/// Byte-wise reading and writing of plain values for checkpoints.  Not part of the
+/// library's interface.
+namespace serialize
+{
+/// Write a plain value to a binary stream.
+template <typename T>
+    requires std::is_trivially_copyable_v<T> && (!std::is_pointer_v<T>)
+void write(std::ostream& os, T const& value)
+{
+    os.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+/// Read a plain value from a binary stream.  Check the stream afterwards for failure.
+template <typename T>
+    requires std::is_trivially_copyable_v<T> && (!std::is_pointer_v<T>)
+void read(std::istream& is, T& value)
+{
+    is.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+}
+
+#endif // LOFT_LOFTLIB_SERIALIZE_HH_INCLUDED
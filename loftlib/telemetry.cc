@@ -0,0 +1,208 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "rocket.hh"
+#include "telemetry.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+using namespace std::chrono_literals;
+
+Telemetry::Telemetry(std::string const& path, Format format, std::size_t capacity)
+    : m_os(path, format == Format::binary ? std::ios::binary | std::ios::trunc
+           : std::ios::trunc),
+      m_format(format),
+      m_queue(capacity),
+      m_open(m_os.good())
+{
+    if (m_format == Format::binary)
+        m_os.write("LoftTlm1", 8);
+    else
+        m_os << "time,channel,value\n" << std::setprecision(17);
+
+    m_writer = std::jthread([this](std::stop_token stop) {
+        while (!stop.stop_requested())
+        {
+            drain();
+            std::this_thread::sleep_for(1ms);
+        }
+        // Catch anything published before the stop.
+        drain();
+        m_os.flush();
+    });
+}
+
+Telemetry::~Telemetry()
+{
+    m_writer.request_stop();
+    m_writer.join();
+}
+
+bool Telemetry::is_open() const
+{
+    return m_open;
+}
+
+int Telemetry::channel(std::string const& name)
+{
+    std::lock_guard lock(m_names_mutex);
+    auto id{find_channel(name)};
+    if (id >= 0)
+        return id;
+    m_names.push_back(name);
+    return m_names.size() - 1;
+}
+
+int Telemetry::channels(std::vector<std::string> const& names)
+{
+    if (names.empty())
+        return -1;
+    // Hold the lock so that no other channel can be registered in between.
+    std::lock_guard lock(m_names_mutex);
+    auto first{find_channel(names.front())};
+    if (first < 0)
+    {
+        if (std::any_of(names.begin(), names.end(),
+                        [this](auto const& name) { return find_channel(name) >= 0; }))
+            return -1;
+        first = m_names.size();
+        m_names.insert(m_names.end(), names.begin(), names.end());
+        return first;
+    }
+    for (std::size_t i = 1; i < names.size(); ++i)
+        if (find_channel(names[i]) != first + static_cast<int>(i))
+            return -1;
+    return first;
+}
+
+int Telemetry::vector_channel(std::string const& name)
+{
+    return channels({name + ".x", name + ".y", name + ".z"});
+}
+
+void Telemetry::publish(int channel, double time, double value)
+{
+    if (channel < 0)
+        return;
+    if (!m_queue.push({time, static_cast<std::uint32_t>(channel), value}))
+        ++m_dropped;
+}
+
+void Telemetry::publish(int channel, double time, V3 const& value)
+{
+    if (channel < 0)
+        return;
+    for (int i = 0; i < 3; ++i)
+        publish(channel + i, time, value[i]);
+}
+
+std::size_t Telemetry::dropped() const
+{
+    return m_dropped;
+}
+
+int Telemetry::find_channel(std::string const& name) const
+{
+    auto it{std::find(m_names.begin(), m_names.end(), name)};
+    return it == m_names.end() ? -1 : it - m_names.begin();
+}
+
+void Telemetry::drain()
+{
+    Sample sample;
+    while (m_queue.pop(sample))
+        write(sample);
+}
+
+void Telemetry::write(Sample const& sample)
+{
+    std::string name;
+    {
+        std::lock_guard lock(m_names_mutex);
+        // Ignore values on channels that were never registered.
+        if (sample.channel >= m_names.size())
+            return;
+        name = m_names[sample.channel];
+    }
+    if (m_format == Format::csv)
+    {
+        m_os << sample.time << ',' << name << ',' << sample.value << '\n';
+        return;
+    }
+
+    // Name any channels that haven't been named yet.
+    for (; m_named <= sample.channel; ++m_named)
+    {
+        std::string name;
+        {
+            std::lock_guard lock(m_names_mutex);
+            name = m_names[m_named];
+        }
+        std::uint32_t header[]{1, static_cast<std::uint32_t>(m_named),
+                               static_cast<std::uint32_t>(name.size())};
+        m_os.write(reinterpret_cast<char const*>(header), sizeof(header));
+        m_os.write(name.data(), name.size());
+    }
+    std::uint32_t header[]{0, sample.channel};
+    m_os.write(reinterpret_cast<char const*>(header), sizeof(header));
+    m_os.write(reinterpret_cast<char const*>(&sample.time), sizeof(sample.time));
+    m_os.write(reinterpret_cast<char const*>(&sample.value), sizeof(sample.value));
+}
+
+Body_Telemetry::Body_Telemetry(Telemetry& telemetry, std::string const& prefix,
+                               std::shared_ptr<Body> body, std::shared_ptr<World> world)
+    : m_telemetry(telemetry),
+      m_body(body),
+      m_rocket(std::dynamic_pointer_cast<Rocket>(body)),
+      m_world(world),
+      m_speed(telemetry.channel(prefix + ".speed"))
+{
+    if (m_world)
+    {
+        m_location = telemetry.channels({prefix + ".lat", prefix + ".lon",
+                                         prefix + ".alt"});
+    }
+    if (m_rocket)
+    {
+        m_fuel = telemetry.channel(prefix + ".fuel");
+        m_thrust = telemetry.vector_channel(prefix + ".thrust");
+    }
+}
+
+void Body_Telemetry::observe(Universe const& universe)
+{
+    auto time{universe.time()};
+    auto v{m_body->v_cm()};
+    if (m_world && m_location >= 0)
+    {
+        // The body's position is relative to the world until it's released.
+        auto r{m_body->is_free() ? m_body->r_cm() : m_body->transform_out(V0)};
+        auto [lat, lon, alt] = m_world->location(r);
+        m_telemetry.publish(m_location, time, lat);
+        m_telemetry.publish(m_location + 1, time, lon);
+        m_telemetry.publish(m_location + 2, time, alt);
+        v -= m_world->v_cm();
+    }
+    m_telemetry.publish(m_speed, time, mag(v));
+    if (m_rocket)
+    {
+        m_telemetry.publish(m_fuel, time, m_rocket->fuel_volume());
+        m_telemetry.publish(m_thrust, time, m_rocket->thrust());
+    }
+}
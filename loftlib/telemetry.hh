@@ -0,0 +1,137 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_TELEMETRY_HH_INCLUDED
+#define LOFT_LOFTLIB_TELEMETRY_HH_INCLUDED
+
+#include "ring-buffer.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Body;
+class Rocket;
+class Universe;
+class V3;
+class World;
+
+/// Logs time-stamped values on named channels to a file.  Publishing puts the value in a
+/// queue and returns; a background thread writes the file.  If the queue fills up,
+/// values are dropped rather than making the publisher wait.
+///
+/// CSV files have a "time,channel,value" line for each value.  Binary files start with
+/// "LoftTlm1".  Then each record starts with a 4-byte kind and a 4-byte channel.  Kind 0
+/// is a value, followed by the time and value as 8-byte floating-point numbers.  Kind 1
+/// names a channel, followed by a 4-byte length and the name.  Each channel is named
+/// before its first value.
+class Telemetry
+{
+public:
+    enum class Format
+    {
+        csv,
+        binary,
+    };
+
+    /// Create or replace a log file and start the writer thread.
+    /// @param capacity The number of values that can be waiting to be written.
+    Telemetry(std::string const& path, Format format = Format::csv,
+              std::size_t capacity = 1 << 16);
+    /// Write the remaining values and close the file.
+    ~Telemetry();
+
+    /// @return True if the file was created.
+    bool is_open() const;
+    /// Register a channel.  Not for use in the integration loop; look up channels
+    /// beforehand.
+    /// @return The channel's id.  The same name always gets the same id.
+    int channel(std::string const& name);
+    /// Register channels with consecutive ids.
+    /// @return The id of the first channel.  The others follow.  -1 if there are no
+    /// names, or if some of the channels were registered separately and the ids aren't
+    /// consecutive.
+    int channels(std::vector<std::string> const& names);
+    /// Register 3 channels for the components of a vector: name.x, name.y, and name.z.
+    /// @return The id of the x channel, or -1 as for channels().
+    int vector_channel(std::string const& name);
+    /// Queue a value for writing.  Only one thread may publish.  Values on negative
+    /// channels are ignored.
+    void publish(int channel, double time, double value);
+    /// Queue the components of a vector registered with vector_channel().  Ignored if the
+    /// channel is negative.
+    void publish(int channel, double time, V3 const& value);
+    /// @return The number of values that were dropped because the queue was full.
+    std::size_t dropped() const;
+
+private:
+    struct Sample
+    {
+        double time;
+        std::uint32_t channel;
+        double value;
+    };
+
+    /// Write the queued values.  Run by the writer thread.
+    void drain();
+    void write(Sample const& sample);
+    /// @return The id of a registered channel, or -1.  The caller must hold the lock.
+    int find_channel(std::string const& name) const;
+
+    std::ofstream m_os;
+    Format m_format;
+    Ring_Buffer<Sample> m_queue;
+    bool m_open; ///< The stream belongs to the writer once it starts.
+    std::atomic<std::size_t> m_dropped{0};
+
+    /// Guards the names, which the writer reads.
+    mutable std::mutex m_names_mutex;
+    std::vector<std::string> m_names;
+    /// The number of names written.  Owned by the writer.
+    std::size_t m_named{0};
+
+    std::jthread m_writer;
+};
+
+/// Publishes the state of a body on channels starting with a given prefix: speed, and
+/// latitude, longitude, and altitude if a world is given.  Rockets also publish fuel
+/// volume and thrust.
+class Body_Telemetry
+{
+public:
+    /// @param world Location and speed are relative to this world if it's not null.
+    Body_Telemetry(Telemetry& telemetry, std::string const& prefix,
+                   std::shared_ptr<Body> body, std::shared_ptr<World> world = {});
+
+    /// Publish the body's current state.  Suitable for Runner::observe().
+    void observe(Universe const& universe);
+
+private:
+    Telemetry& m_telemetry;
+    std::shared_ptr<Body> m_body;
+    std::shared_ptr<Rocket> m_rocket;
+    std::shared_ptr<World> m_world;
+    int m_speed;
+    int m_location{-1}; ///< Latitude.  Longitude and altitude follow.
+    int m_fuel{-1};
+    int m_thrust{-1};
+};
+
+#endif // LOFT_LOFTLIB_TELEMETRY_HH_INCLUDED
@@ -0,0 +1,222 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "terrain.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numbers>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std::numbers;
+
+/// The start of a terrain file.
+struct Terrain_Header
+{
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t samples;
+    std::uint32_t rows;
+    std::uint32_t columns;
+    double min;
+    double max;
+    std::array<char, 24> unused;
+};
+static_assert(sizeof(Terrain_Header) == 64);
+
+static constexpr std::array<char, 8> terrain_magic{'L', 'o', 'f', 't', 'T', 'e', 'r', 'r'};
+static constexpr std::uint32_t terrain_version{1};
+
+/// @return Bytes per tile.
+static std::size_t tile_size(std::size_t samples)
+{
+    return sizeof(std::int16_t)*samples*samples;
+}
+
+Terrain::Terrain(std::string const& path, std::size_t cache_tiles)
+    : m_path{path},
+      m_cache_tiles{std::max<std::size_t>(1, cache_tiles)}
+{
+    auto fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return;
+    struct stat st;
+    auto size{::fstat(fd, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0};
+    Terrain_Header header;
+    if (size < sizeof(header)
+        || ::pread(fd, &header, sizeof(header), 0) != sizeof(header)
+        || header.magic != terrain_magic
+        || header.version != terrain_version
+        || header.samples < 2
+        // Divide rather than multiply so that large dimensions can't overflow.
+        || header.samples > (size - sizeof(header))/sizeof(std::int16_t)/header.samples
+        || static_cast<std::size_t>(header.rows)*header.columns
+           > (size - sizeof(header))/tile_size(header.samples))
+    {
+        ::close(fd);
+        return;
+    }
+    m_fd = fd;
+    m_rows = header.rows;
+    m_columns = header.columns;
+    m_samples = header.samples;
+    m_min = header.min;
+    m_max = header.max;
+}
+
+Terrain::~Terrain()
+{
+    for (auto const& t : m_cache)
+        ::munmap(t.map, t.length);
+    if (m_fd >= 0)
+        ::close(m_fd);
+}
+
+bool Terrain::write(std::string const& path, std::size_t rows, std::size_t columns,
+                    std::size_t samples,
+                    std::function<double(double, double)> const& height)
+{
+    assert(rows > 0 && columns > 0 && samples >= 2);
+    std::ofstream os(path, std::ios::binary);
+    if (!os)
+        return false;
+    Terrain_Header header{terrain_magic, terrain_version,
+                          static_cast<std::uint32_t>(samples),
+                          static_cast<std::uint32_t>(rows),
+                          static_cast<std::uint32_t>(columns),
+                          INT16_MAX, INT16_MIN, {}};
+    // Write the header again at the end when the range is known.
+    os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    auto d_lat{pi/rows};
+    auto d_lon{2*pi/columns};
+    std::vector<std::int16_t> tile(samples*samples);
+    for (std::size_t row{0}; row < rows; ++row)
+        for (std::size_t col{0}; col < columns; ++col)
+        {
+            for (std::size_t i{0}; i < samples; ++i)
+                for (std::size_t j{0}; j < samples; ++j)
+                {
+                    auto lat{-pi/2 + (row + static_cast<double>(i)/(samples - 1))*d_lat};
+                    auto lon{-pi + (col + static_cast<double>(j)/(samples - 1))*d_lon};
+                    auto h{std::clamp(std::round(height(lat, lon)), double(INT16_MIN),
+                                      double(INT16_MAX))};
+                    header.min = std::min(header.min, h);
+                    header.max = std::max(header.max, h);
+                    tile[i*samples + j] = static_cast<std::int16_t>(h);
+                }
+            os.write(reinterpret_cast<char const*>(tile.data()), tile_size(samples));
+        }
+    os.seekp(0);
+    os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    return os && os.flush();
+}
+
+bool Terrain::is_open() const
+{
+    return m_fd >= 0;
+}
+
+std::string const& Terrain::path() const
+{
+    return m_path;
+}
+
+double Terrain::min_height() const
+{
+    return m_min;
+}
+
+double Terrain::max_height() const
+{
+    return m_max;
+}
+
+std::size_t Terrain::mapped_tiles() const
+{
+    std::lock_guard lock{m_mutex};
+    return m_cache.size();
+}
+
+std::int16_t const* Terrain::tile(std::size_t index) const
+{
+    ++m_clock;
+    auto it{std::find_if(m_cache.begin(), m_cache.end(),
+                         [index](Tile const& t) { return t.index == index; })};
+    if (it != m_cache.end())
+    {
+        it->used = m_clock;
+        return it->samples;
+    }
+    if (m_cache.size() == m_cache_tiles)
+    {
+        auto lru{std::min_element(m_cache.begin(), m_cache.end(),
+                                  [](Tile const& t1, Tile const& t2) {
+                                      return t1.used < t2.used;
+                                  })};
+        ::munmap(lru->map, lru->length);
+        m_cache.erase(lru);
+    }
+    // Mappings have to start on a page boundary.
+    static auto const page{static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))};
+    auto offset{sizeof(Terrain_Header) + index*tile_size(m_samples)};
+    auto start{offset/page*page};
+    auto length{offset - start + tile_size(m_samples)};
+    auto* map{::mmap(nullptr, length, PROT_READ, MAP_SHARED, m_fd,
+                     static_cast<off_t>(start))};
+    if (map == MAP_FAILED)
+        return nullptr;
+    auto samples{reinterpret_cast<std::int16_t const*>(static_cast<char const*>(map)
+                                                       + (offset - start))};
+    m_cache.push_back({index, map, length, samples, m_clock});
+    return samples;
+}
+
+double Terrain::height(double lat, double lon) const
+{
+    if (!is_open())
+        return 0.0;
+    // Find the tile and the position within it in units of samples.
+    auto locate{[this](double angle, double span, std::size_t tiles,
+                       std::size_t& tile, std::size_t& sample, double& fraction) {
+        auto u{std::clamp(angle/span, 0.0, 1.0)*tiles};
+        tile = std::min(static_cast<std::size_t>(u), tiles - 1);
+        auto s{(u - tile)*(m_samples - 1)};
+        sample = std::min(static_cast<std::size_t>(s), m_samples - 2);
+        fraction = s - sample;
+    }};
+    std::size_t row, col, i, j;
+    double f_lat, f_lon;
+    locate(lat + pi/2, pi, m_rows, row, i, f_lat);
+    auto east{lon + pi - 2*pi*std::floor((lon + pi)/(2*pi))};
+    locate(east, 2*pi, m_columns, col, j, f_lon);
+
+    std::lock_guard lock{m_mutex};
+    auto t{tile(row*m_columns + col)};
+    if (!t)
+        return 0.0;
+    auto at{[this, t](std::size_t i, std::size_t j) {
+        return static_cast<double>(t[i*m_samples + j]);
+    }};
+    return (1 - f_lat)*((1 - f_lon)*at(i, j) + f_lon*at(i, j + 1))
+        + f_lat*((1 - f_lon)*at(i + 1, j) + f_lon*at(i + 1, j + 1));
+}
@@ -0,0 +1,94 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_TERRAIN_HH_INCLUDED
+#define LOFT_LOFTLIB_TERRAIN_HH_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A terrain file holds surface heights on a grid of tiles that cover a world.  Tile rows
+// run south to north and columns run west to east from longitude -180°.  Each tile is a
+// square of 16-bit heights in meters, also south to north and west to east, with samples
+// on its edges so that it can be interpolated without its neighbors.  A 64-byte header
+// gives the grid and the range of heights.  Values are in the machine's native format.
+
+/// Surface heights above a world's radius, read from a terrain file.  Tiles are
+/// memory-mapped when they're first needed and unmapped when they're the least recently
+/// used and the cache is full, so a large file never has to fit in memory.  Lookups may
+/// come from several threads.
+class Terrain
+{
+public:
+    /// Open a terrain file.
+    /// @param cache_tiles The most tiles to keep mapped at once.
+    explicit Terrain(std::string const& path, std::size_t cache_tiles = 16);
+    ~Terrain();
+    Terrain(Terrain const&) = delete;
+    Terrain& operator=(Terrain const&) = delete;
+
+    /// Write a terrain file.
+    /// @param rows, columns The number of tiles in latitude and longitude.
+    /// @param samples The number of samples on a side of each tile.
+    /// @param height Gives the height in meters at a latitude and longitude in radians.
+    /// @return False if the file could not be written.
+    static bool write(std::string const& path, std::size_t rows, std::size_t columns,
+                      std::size_t samples,
+                      std::function<double(double, double)> const& height);
+
+    /// @return True if the file was opened and has a valid header.
+    bool is_open() const;
+    /// @return The file's path.
+    std::string const& path() const;
+    /// @return The height at a latitude and longitude, interpolated between samples: m
+    double height(double lat, double lon) const;
+    /// @return The lowest and highest heights in the file: m
+    double min_height() const;
+    double max_height() const;
+    /// @return The number of tiles that are mapped.
+    std::size_t mapped_tiles() const;
+
+private:
+    /// A mapped tile.
+    struct Tile
+    {
+        std::size_t index;
+        void* map;
+        std::size_t length;
+        std::int16_t const* samples;
+        /// When the tile was last used, for finding the least recently used one.
+        std::uint64_t used;
+    };
+    /// @return The samples of a tile, mapping it if necessary.  Call with the mutex held.
+    std::int16_t const* tile(std::size_t index) const;
+
+    std::string m_path;
+    int m_fd{-1};
+    std::size_t m_rows{0};
+    std::size_t m_columns{0};
+    std::size_t m_samples{0};
+    double m_min{0.0};
+    double m_max{0.0};
+    std::size_t m_cache_tiles;
+    mutable std::mutex m_mutex;
+    mutable std::vector<Tile> m_cache;
+    mutable std::uint64_t m_clock{0};
+};
+
+#endif // LOFT_LOFTLIB_TERRAIN_HH_INCLUDED
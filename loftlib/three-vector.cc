@@ -330,3 +330,12 @@ std::tuple<V3, double> axis_angle(M3 const& m)
     }
     return {V3(x, y, z), acos(w) * 2.0};
 }
+
+M3 slerp(M3 const& m1, M3 const& m2, double t)
+{
+    auto [axis, angle] = axis_angle(tr(m1)*m2);
+    // The angle is NaN if round-off puts the cosine slightly above 1.
+    if (!(angle > 0.0))
+        return m1;
+    return rot(m1, t*angle*unit(axis));
+}
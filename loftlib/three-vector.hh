@@ -51,6 +51,9 @@ M3 inv(M3 const& m);
 M3 tr(M3 const& m);
 // @return An axis vector and an angle in radians.  The length of the vector is arbitrary.
 std::tuple<V3, double> axis_angle(M3 const& m);
+// @return The orientation a fraction t of the way from m1 to m2 by rotating about a fixed
+// axis.
+M3 slerp(M3 const& m1, M3 const& m2, double t);
 
 V3 operator-(V3 const& v);
 
@@ -0,0 +1,268 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "body.hh"
+#include "trajectory.hh"
+#include "universe.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// The start of a trajectory file.  Padded so that frames are aligned.
+struct Trajectory_Header
+{
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t columns;
+    std::uint64_t bodies;
+    std::uint64_t frames;
+    std::uint64_t frame_size;
+    std::array<char, 24> unused;
+};
+static_assert(sizeof(Trajectory_Header) == 64);
+
+static constexpr std::array<char, 8> trajectory_magic{'L', 'o', 'f', 't', 'T', 'r', 'a', 'j'};
+static constexpr std::uint32_t trajectory_version{1};
+/// Id, position, velocity and orientation.
+static constexpr std::uint32_t columns{10};
+
+/// @return Bytes per frame: the time plus a column of 8-byte values per quantity.
+static std::size_t frame_size(std::size_t bodies)
+{
+    return sizeof(double)*(1 + columns*bodies);
+}
+
+V3 Trajectory_Frame::r(std::size_t i) const
+{
+    return {x[i], y[i], z[i]};
+}
+
+V3 Trajectory_Frame::v(std::size_t i) const
+{
+    return {vx[i], vy[i], vz[i]};
+}
+
+M3 Trajectory_Frame::orientation(std::size_t i) const
+{
+    return rot(M1, V3(ax[i], ay[i], az[i]));
+}
+
+Trajectory_Sink::Trajectory_Sink(std::size_t every)
+    : m_every(std::max<std::size_t>(1, every))
+{
+}
+
+void Trajectory_Sink::observe(Universe const& universe)
+{
+    if (m_calls++ % m_every == 0)
+        record(universe);
+}
+
+Trajectory_Sink::State Trajectory_Sink::state(Body const& b, V3 const& origin)
+{
+    // The orientation matrix relative to the absolute frame.
+    auto o{b.is_free() ? b.orientation()
+           : tr(M3(b.rotate_out(Vx), b.rotate_out(Vy), b.rotate_out(Vz)))};
+    auto [axis, angle] = axis_angle(o);
+    return {origin + b.transform_out(V0),
+            b.is_free() ? b.v_cm() : V0,
+            angle > 0.0 ? angle*unit(axis) : V0};
+}
+
+Trajectory_Writer::Trajectory_Writer(std::string const& path, std::size_t bodies,
+                                     std::size_t every)
+    : Trajectory_Sink(every),
+      m_fd(::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)),
+      m_bodies(bodies),
+      m_frame_size(frame_size(bodies))
+{
+    if (m_fd < 0 || !reserve())
+        return;
+    Trajectory_Header header{trajectory_magic, trajectory_version, columns,
+                             bodies, 0, m_frame_size, {}};
+    std::memcpy(m_data, &header, sizeof(header));
+}
+
+Trajectory_Writer::~Trajectory_Writer()
+{
+    if (m_data)
+        ::munmap(m_data, m_mapped);
+    if (m_fd >= 0)
+    {
+        // Drop the unused space at the end.  If that fails the file is just bigger than
+        // it needs to be.  Readers go by the frame count in the header and ignore the
+        // rest.
+        [[maybe_unused]] auto truncated{
+            ::ftruncate(m_fd, sizeof(Trajectory_Header) + m_frames*m_frame_size)};
+        ::close(m_fd);
+    }
+}
+
+bool Trajectory_Writer::is_open() const
+{
+    return m_data;
+}
+
+bool Trajectory_Writer::reserve()
+{
+    auto needed{sizeof(Trajectory_Header) + (m_frames + 1)*m_frame_size};
+    if (needed <= m_mapped)
+        return true;
+
+    // Double the file so that growing is rare.
+    auto size{std::max(needed, 2*m_mapped)};
+    if (m_data)
+        ::munmap(m_data, m_mapped);
+    m_data = nullptr;
+    m_mapped = 0;
+    if (::ftruncate(m_fd, size) != 0)
+        return false;
+    auto* data{::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0)};
+    if (data == MAP_FAILED)
+        return false;
+    m_data = static_cast<char*>(data);
+    m_mapped = size;
+    return true;
+}
+
+void Trajectory_Writer::record(Universe const& universe)
+{
+    assert(universe.bodies().size() == m_bodies);
+    if (!m_data || !reserve())
+        return;
+
+    auto* frame{m_data + sizeof(Trajectory_Header) + m_frames*m_frame_size};
+    auto time{universe.time()};
+    std::memcpy(frame, &time, sizeof(time));
+    auto* id{reinterpret_cast<std::uint64_t*>(frame + sizeof(double))};
+    auto* column{reinterpret_cast<double*>(id + m_bodies)};
+    auto n{m_bodies};
+    std::size_t i{0};
+    for (auto const& b : universe.bodies())
+    {
+        auto [r, v, a] = state(*b, universe.origin());
+        id[i] = i;
+        column[i] = r.x;
+        column[n + i] = r.y;
+        column[2*n + i] = r.z;
+        column[3*n + i] = v.x;
+        column[4*n + i] = v.y;
+        column[5*n + i] = v.z;
+        column[6*n + i] = a.x;
+        column[7*n + i] = a.y;
+        column[8*n + i] = a.z;
+        ++i;
+    }
+    ++m_frames;
+    reinterpret_cast<Trajectory_Header*>(m_data)->frames = m_frames;
+}
+
+std::size_t Trajectory_Writer::frames() const
+{
+    return m_frames;
+}
+
+Trajectory_Reader::Trajectory_Reader(std::string const& path)
+{
+    auto fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return;
+    struct stat st;
+    auto size{::fstat(fd, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0};
+    auto* data{size >= sizeof(Trajectory_Header)
+               ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED};
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return;
+
+    m_data = static_cast<char const*>(data);
+    m_size = size;
+    Trajectory_Header header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if (header.magic != trajectory_magic
+        || header.version != trajectory_version
+        || header.columns != columns
+        // Divide rather than multiply so that large counts can't overflow.
+        || header.bodies > (size - sizeof(header))/(columns*sizeof(double))
+        || header.frame_size != frame_size(header.bodies)
+        || header.frames > (size - sizeof(header))/header.frame_size)
+    {
+        ::munmap(const_cast<char*>(m_data), m_size);
+        m_data = nullptr;
+        return;
+    }
+    m_bodies = header.bodies;
+    m_frames = header.frames;
+    m_frame_size = header.frame_size;
+}
+
+Trajectory_Reader::~Trajectory_Reader()
+{
+    if (m_data)
+        ::munmap(const_cast<char*>(m_data), m_size);
+}
+
+bool Trajectory_Reader::is_open() const
+{
+    return m_data;
+}
+
+std::size_t Trajectory_Reader::bodies() const
+{
+    return m_bodies;
+}
+
+std::size_t Trajectory_Reader::frames() const
+{
+    return m_frames;
+}
+
+Trajectory_Frame Trajectory_Reader::frame(std::size_t index) const
+{
+    assert(index < m_frames);
+    auto const* frame{m_data + sizeof(Trajectory_Header) + index*m_frame_size};
+    double time;
+    std::memcpy(&time, frame, sizeof(time));
+    auto n{m_bodies};
+    auto const* id{reinterpret_cast<std::uint64_t const*>(frame + sizeof(double))};
+    auto const* c{reinterpret_cast<double const*>(id + n)};
+    return {time, {id, n},
+            {c, n}, {c + n, n}, {c + 2*n, n},
+            {c + 3*n, n}, {c + 4*n, n}, {c + 5*n, n},
+            {c + 6*n, n}, {c + 7*n, n}, {c + 8*n, n}};
+}
+
+std::size_t Trajectory_Reader::find(double time) const
+{
+    // Binary search on the time at the start of each frame.
+    std::size_t lo{0};
+    std::size_t hi{m_frames};
+    while (hi - lo > 1)
+    {
+        auto mid{(lo + hi)/2};
+        if (frame(mid).time <= time)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
@@ -0,0 +1,148 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_TRAJECTORY_HH_INCLUDED
+#define LOFT_LOFTLIB_TRAJECTORY_HH_INCLUDED
+
+#include "three-vector.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+class Body;
+class Universe;
+
+// A trajectory file holds the state of every body in a universe at a series of times.  It
+// starts with a fixed-size header followed by frames that all have the same size, so any
+// frame can be found without reading the ones before it.  Within a frame the values are
+// stored by column: the time, then the body ids, then each component of position,
+// velocity and orientation for all bodies.  Orientation is stored as a rotation vector:
+// the axis scaled by the angle.  Values are in the machine's native format.
+
+/// One time slice of a trajectory.  The columns point into the file's memory and are only
+/// valid while the reader is.
+struct Trajectory_Frame
+{
+    double time;
+    std::span<std::uint64_t const> id; ///< Index of the body in the universe.
+    std::span<double const> x;
+    std::span<double const> y;
+    std::span<double const> z;
+    std::span<double const> vx;
+    std::span<double const> vy;
+    std::span<double const> vz;
+    std::span<double const> ax; ///< Rotation vector x.
+    std::span<double const> ay; ///< Rotation vector y.
+    std::span<double const> az; ///< Rotation vector z.
+
+    /// @return The absolute position of a body's origin.
+    V3 r(std::size_t i) const;
+    /// @return The velocity of a body's center of mass.
+    V3 v(std::size_t i) const;
+    /// @return The orientation of a body.
+    M3 orientation(std::size_t i) const;
+};
+
+/// Something that records the state of a universe over time.
+class Trajectory_Sink
+{
+public:
+    /// @param every Record every nth call to observe().
+    explicit Trajectory_Sink(std::size_t every = 1);
+    virtual ~Trajectory_Sink() = default;
+
+    /// Append the universe's current state.  The universe must have the number of bodies
+    /// the sink was made for.  Captured bodies have zero velocity.
+    virtual void record(Universe const& universe) = 0;
+    /// Call after each step to record every nth state.  Suitable for Runner::observe().
+    void observe(Universe const& universe);
+
+protected:
+    /// What's recorded for each body.
+    struct State
+    {
+        V3 r; ///< Absolute position of the origin.
+        V3 v; ///< Velocity of the center of mass.
+        V3 rotation; ///< Absolute orientation as a rotation vector.
+    };
+    /// @param origin The absolute position of the universe's origin.
+    static State state(Body const& body, V3 const& origin);
+
+private:
+    std::size_t m_every;
+    std::size_t m_calls{0};
+};
+
+/// Appends frames to a memory-mapped trajectory file.  The file grows as needed.
+class Trajectory_Writer : public Trajectory_Sink
+{
+public:
+    /// Create or replace a trajectory file.
+    /// @param bodies The number of bodies in each frame.
+    Trajectory_Writer(std::string const& path, std::size_t bodies, std::size_t every = 1);
+    ~Trajectory_Writer();
+    Trajectory_Writer(Trajectory_Writer const&) = delete;
+    Trajectory_Writer& operator=(Trajectory_Writer const&) = delete;
+
+    /// @return True if the file was created.
+    bool is_open() const;
+    void record(Universe const& universe) override;
+    /// @return The number of frames written.
+    std::size_t frames() const;
+
+private:
+    /// Make sure the mapping has room for one more frame.
+    bool reserve();
+
+    int m_fd{-1};
+    std::size_t m_bodies;
+    std::size_t m_frame_size;
+    std::size_t m_frames{0};
+    char* m_data{nullptr};
+    std::size_t m_mapped{0};
+};
+
+/// Random access to the frames of a trajectory file.
+class Trajectory_Reader
+{
+public:
+    explicit Trajectory_Reader(std::string const& path);
+    ~Trajectory_Reader();
+    Trajectory_Reader(Trajectory_Reader const&) = delete;
+    Trajectory_Reader& operator=(Trajectory_Reader const&) = delete;
+
+    /// @return True if the file was mapped and has a valid header.
+    bool is_open() const;
+    /// @return The number of bodies in each frame.
+    std::size_t bodies() const;
+    /// @return The number of frames.
+    std::size_t frames() const;
+    /// @return The frame with the given index.
+    Trajectory_Frame frame(std::size_t index) const;
+    /// @return The index of the last frame at or before the given time, or 0 if the time
+    /// is before the first frame.  Frames must be in time order.
+    std::size_t find(double time) const;
+
+private:
+    char const* m_data{nullptr};
+    std::size_t m_size{0};
+    std::size_t m_bodies{0};
+    std::size_t m_frames{0};
+    std::size_t m_frame_size{0};
+};
+
+#endif // LOFT_LOFTLIB_TRAJECTORY_HH_INCLUDED
@@ -0,0 +1,69 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_TRIPLE_BUFFER_HH_INCLUDED
+#define LOFT_LOFTLIB_TRIPLE_BUFFER_HH_INCLUDED
+
+#include <array>
+#include <atomic>
+
+/// Hands the latest value from one producer thread to one consumer thread without locks.
+/// The producer fills the back slot and publishes it.  The consumer takes the most recently
+/// published value into the front slot.  Neither thread ever waits for the other, and the
+/// consumer skips values that were published while it was busy.
+template <typename T>
+class Triple_Buffer
+{
+public:
+    /// @return The slot for the producer to fill before calling publish().
+    T& back()
+    {
+        return m_slots[m_back];
+    }
+    /// Make the back slot available to the consumer.  The producer gets a new back slot.
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel) & index;
+    }
+    /// Take the most recently published value if there's one that hasn't been taken.
+    /// @return True if front() changed.
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & fresh))
+            return false;
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & index;
+        return true;
+    }
+    /// @return The consumer's current value.
+    T const& front() const
+    {
+        return m_slots[m_front];
+    }
+
+private:
+    static constexpr unsigned index{3};
+    /// Set in m_middle when the middle slot holds a value the consumer hasn't taken.
+    static constexpr unsigned fresh{4};
+
+    std::array<T, 3> m_slots;
+    /// Owned by the producer.
+    unsigned m_back{0};
+    /// The slot being exchanged, and the fresh bit.
+    std::atomic<unsigned> m_middle{1};
+    /// Owned by the consumer.
+    unsigned m_front{2};
+};
+
+#endif // LOFT_LOFTLIB_TRIPLE_BUFFER_HH_INCLUDED
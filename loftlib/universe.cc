@@ -16,14 +16,32 @@
 #include "body.hh"
 #include "units.hh"
 #include "universe.hh"
+#include "world.hh"
 
+#include <algorithm>
 #include <cassert>
+#include <utility>
 
-V3 gravity(const Body& p1, const Body& p2)
+/// @return The force of p2's gravity on p1.
+/// @param potential If not null, the pair's potential energy is added to it.
+V3 gravity(const Body& p1, const Body& p2, double* potential = nullptr)
 {
     auto r{p2.r_cm() - p1.r_cm()};
     auto r2{dot(r, r)};
-    return r2 < 1e-3 ? V0 : unit(r)*consts::G*p1.m()*p2.m()/dot(r, r);
+    if (r2 < 1e-3)
+        return V0;
+    auto d{mag(r)};
+    auto force{r/d*consts::G*p1.m()*p2.m()/r2};
+    // The force is along r, so its dot product with r is G m1 m2/d without another
+    // division.
+    if (potential)
+        *potential -= dot(force, r);
+    return force;
+}
+
+double Diagnostics::energy() const
+{
+    return kinetic + potential;
 }
 
 Universe::Universe(bool handle_collision)
@@ -33,36 +51,194 @@ Universe::Universe(bool handle_collision)
 
 void Universe::add(Body_ptr bp)
 {
-    m_body.push_back(bp);
+    bp->set_compensated(m_summation == Summation::compensated);
+    if (auto world{std::dynamic_pointer_cast<World>(bp)})
+    {
+        world->set_origin(m_origin);
+        m_worlds.push_back(std::move(world));
+    }
+    m_body.push_back(std::move(bp));
 }
 
 void Universe::step(double time)
 {
+    auto end{m_time + time};
+    auto end_error{0.0};
+    if (m_summation == Summation::compensated)
+    {
+        auto y{time - m_time_error};
+        end = m_time + y;
+        end_error = (end - m_time) - y;
+    }
+    auto split{false};
+    while (!m_actions.empty() && m_actions.begin()->first <= end)
+    {
+        // Stop at the action's time.  Use the scheduled time rather than the sum of the
+        // partial steps so that rounding doesn't accumulate.
+        auto it{m_actions.begin()};
+        if (it->first > m_time)
+        {
+            advance(it->first - m_time);
+            m_time = it->first;
+            m_time_error = 0.0;
+            split = true;
+        }
+        auto action{std::move(it->second)};
+        m_actions.erase(it);
+        action(*this);
+    }
+    if (!split)
+        advance(time);
+    else if (end > m_time)
+        advance(end - m_time);
+    m_time = end;
+    m_time_error = end_error;
+    if (m_anchor)
+    {
+        auto r{m_anchor->is_free() ? m_anchor->r_cm() : m_anchor->transform_out(V0)};
+        if (mag(r) > m_rebase_distance)
+            rebase(r);
+    }
+
+    if (m_watches.empty())
+        return;
+    // Take the met conditions out before running any actions so that actions can add
+    // new ones.  New conditions are first checked at the end of the next step.
+    auto watches{std::move(m_watches)};
+    m_watches.clear();
+    std::vector<Action> ready;
+    for (auto& watch : watches)
+    {
+        if (watch.first(*this))
+            ready.push_back(std::move(watch.second));
+        else
+            m_watches.push_back(std::move(watch));
+    }
+    for (auto& action : ready)
+        action(*this);
+}
+
+void Universe::schedule(double time, Action action)
+{
+    m_actions.emplace(time, std::move(action));
+}
+
+std::size_t Universe::scheduled() const
+{
+    return m_actions.size();
+}
+
+void Universe::watch(Condition condition, Action action)
+{
+    m_watches.emplace_back(std::move(condition), std::move(action));
+}
+
+std::size_t Universe::watched() const
+{
+    return m_watches.size();
+}
+
+void Universe::advance(double time)
+{
+    // Forces are evaluated halfway through the step.  Move the free bodies forward by
+    // half a step at their old velocities, apply the impulses, and take back half a step
+    // at their new velocities.  Then step() leaves each body where the old velocity for
+    // the first half and the new one for the second would take it.  That's the
+    // drift-kick-drift leapfrog method, which is second order in the time step where
+    // applying the impulses at the start is first order.  Bodies still rotate and
+    // rockets still burn once per step.
+    for (auto& b : m_body)
+        if (b->is_free())
+            b->displace(0.5*time*b->v_cm());
+
+    Diagnostics totals;
+    if (m_diagnose)
+    {
+        totals.time = m_time + 0.5*time;
+        for (auto& b : m_body)
+        {
+            if (!b->is_free())
+                continue;
+            auto m{b->m()};
+            auto v{b->v_cm()};
+            auto L_spin{b->I()*b->omega()};
+            totals.kinetic += 0.5*(m*dot(v, v) + dot(b->omega(), L_spin));
+            totals.momentum += m*v;
+            totals.angular_momentum += m*cross(m_origin + b->r_cm(), v) + L_spin;
+        }
+    }
+
     // Change velocities due to gravity.
-    for(auto it1 = m_body.begin(); it1 != m_body.end(); ++it1)
+    if (m_precision == Precision::mixed)
     {
-        if (!(*it1)->is_free())
-            continue;
-        auto it2{it1};
-        for(auto it2{std::next(it1)}; it2 != m_body.end(); ++it2)
+        std::vector<Body*> free;
+        for (auto const& b : m_body)
+            if (b->is_free())
+                free.push_back(b.get());
+        totals.potential = m_mixed_gravity.apply(free, time, m_diagnose);
+    }
+    else
+    {
+        for(auto it1 = m_body.begin(); it1 != m_body.end(); ++it1)
         {
-            assert(it1 != it2);
-            if (!(*it2)->is_free())
+            if (!(*it1)->is_free())
                 continue;
-            auto& p1{**it1};
-            auto& p2{**it2};
-            if (p1.m() == p2.m())
+            auto it2{it1};
+            for(auto it2{std::next(it1)}; it2 != m_body.end(); ++it2)
+            {
+                assert(it1 != it2);
+                if (!(*it2)->is_free())
+                    continue;
+                auto& p1{**it1};
+                auto& p2{**it2};
+                // Bodies on scripted paths don't need each other's gravity.
+                if (p1.m() == p2.m() || (p1.is_scripted() && p2.is_scripted()))
+                    continue;
+                auto force{gravity(p1, p2, m_diagnose ? &totals.potential : nullptr)};
+                auto imp{force*time};
+                p1.impulse(imp);
+                p2.impulse(-imp);
+            }
+        }
+    }
+
+    if (m_diagnose)
+    {
+        m_previous_diagnostics = m_diagnostics;
+        m_diagnostics = totals;
+        m_diagnosed = std::min(m_diagnosed + 1, 2);
+    }
+
+    // Perturb the paths of bodies around worlds that aren't point masses.
+    for (auto const& world : m_worlds)
+    {
+        if (!world->harmonics() || !world->is_free())
+            continue;
+        for (auto& b : m_body)
+        {
+            if (b.get() == world.get() || !b->is_free())
                 continue;
-            auto force{gravity(p1, p2)};
-            auto imp{force*time};
-            p1.impulse(imp);
-            p2.impulse(-imp);
+            auto imp{b->m()*world->perturbation(b->r_cm())*time};
+            b->impulse(imp);
+            world->impulse(-imp);
         }
     }
 
+    // Slow bodies that have drag areas in the worlds' atmospheres.
+    for (auto const& world : m_worlds)
+    {
+        if (!world->atmosphere() || !world->is_free())
+            continue;
+        for (auto& b : m_body)
+            if (b->is_free() && b->drag_area() > 0.0)
+                b->impulse(world->drag(*b, time));
+    }
+
+    for (auto& b : m_body)
+        if (b->is_free())
+            b->displace(-0.5*time*b->v_cm());
     for (auto& b : m_body)
         b->step(time);
-    m_time += time;
 
     if (!m_handle_collision)
         return;
@@ -88,3 +264,73 @@ double Universe::time() const
 {
     return m_time;
 }
+
+std::list<Universe::Body_ptr> const& Universe::bodies() const
+{
+    return m_body;
+}
+
+V3 const& Universe::origin() const
+{
+    return m_origin;
+}
+
+void Universe::rebase(V3 const& offset)
+{
+    // Captured bodies are relative to their captors.
+    for (auto& b : m_body)
+        if (b->is_free())
+            b->rebase(offset);
+    m_origin += offset;
+}
+
+void Universe::set_precision(Precision precision)
+{
+    m_precision = precision;
+}
+
+Universe::Precision Universe::precision() const
+{
+    return m_precision;
+}
+
+void Universe::set_summation(Summation summation)
+{
+    m_summation = summation;
+    for (auto& b : m_body)
+        b->set_compensated(summation == Summation::compensated);
+}
+
+Universe::Summation Universe::summation() const
+{
+    return m_summation;
+}
+
+void Universe::set_diagnostics(bool on)
+{
+    m_diagnose = on;
+    m_diagnosed = 0;
+    m_diagnostics = {};
+    m_previous_diagnostics = {};
+}
+
+Diagnostics const& Universe::diagnostics() const
+{
+    return m_diagnostics;
+}
+
+Diagnostics Universe::drift() const
+{
+    if (m_diagnosed < 2)
+        return {};
+    auto const& d1{m_previous_diagnostics};
+    auto const& d2{m_diagnostics};
+    return {d2.time - d1.time, d2.kinetic - d1.kinetic, d2.potential - d1.potential,
+            d2.momentum - d1.momentum, d2.angular_momentum - d1.angular_momentum};
+}
+
+void Universe::set_floating_origin(Body_ptr anchor, double distance)
+{
+    m_anchor = std::move(anchor);
+    m_rebase_distance = distance;
+}
@@ -16,26 +16,148 @@
 #ifndef LOFT_LOFTLIB_UNIVERSE_HH_INCLUDED
 #define LOFT_LOFTLIB_UNIVERSE_HH_INCLUDED
 
+#include "gravity.hh"
+#include "three-vector.hh"
+
+#include <functional>
 #include <memory>
 #include <list>
+#include <map>
+#include <vector>
 
 class Body;
+class World;
+
+/// Totals over a universe's free bodies of quantities that gravity between bodies
+/// conserves.  Drag, thrust, gravity fields and scripted paths change them.
+struct Diagnostics
+{
+    double time{0.0}; ///< When they were taken: s
+    double kinetic{0.0}; ///< Kinetic energy of translation and rotation: J
+    double potential{0.0}; ///< Potential energy of gravity between bodies: J
+    V3 momentum{V0}; ///< kg m/s
+    V3 angular_momentum{V0}; ///< About the absolute origin, including spin: kg m²/s
+
+    /// @return Kinetic plus potential energy: J
+    double energy() const;
+};
 
 class Universe
 {
     using Body_ptr = std::shared_ptr<Body>;
 
 public:
+    /// How gravity between bodies is evaluated.
+    enum class Precision
+    {
+        /// Forces between each pair of bodies in double precision.
+        full,
+        /// Accelerations in single precision.  See Mixed_Gravity.  Much faster for
+        /// many bodies.  Each pair's force is good to about 1e-7, but errors in the
+        /// total grow where many forces cancel.
+        mixed,
+    };
+
+    /// How positions, velocities and the time are summed over steps.
+    enum class Summation
+    {
+        /// Plain addition.
+        plain,
+        /// Kahan's compensated summation.  See Body::set_compensated().  Long runs stay
+        /// accurate with larger steps.
+        compensated,
+    };
+
+    /// Something to do at a scheduled time, e.g. fire an engine or release a body.
+    using Action = std::function<void(Universe&)>;
+    /// A test of the universe's state.
+    using Condition = std::function<bool(Universe const&)>;
+
     Universe(bool handle_collision);
     void add(Body_ptr bp);
+    /// Advance by the given time.  The step is split at scheduled times so that actions
+    /// happen exactly when they're scheduled, no matter how long the step is.
     void step(double time);
+    /// Run an action at the given time.  Actions at the same time run in the order they
+    /// were scheduled.  Actions may schedule other actions.  An action scheduled for a
+    /// time that has passed runs at the start of the next step.
+    void schedule(double time, Action action);
+    /// @return The number of actions waiting to run.
+    std::size_t scheduled() const;
+    /// Run an action after the first step that ends with the condition true.  Conditions
+    /// are only checked at the ends of steps, and only until they're met.
+    void watch(Condition condition, Action action);
+    /// @return The number of conditions being watched.
+    std::size_t watched() const;
 
     double time() const;
+    /// @return The bodies in the order they were added.
+    std::list<Body_ptr> const& bodies() const;
+
+    /// @return The absolute position of the origin of the bodies' coordinates.  Bodies'
+    /// positions are relative to it.  It starts at zero.
+    V3 const& origin() const;
+    /// Move the origin of the bodies' coordinates.  Free bodies are shifted so that
+    /// nothing moves in absolute terms.  Velocities don't change.
+    /// @param offset The new origin relative to the current one.
+    void rebase(V3 const& offset);
+    /// Keep the origin near a body so that positions near it have full precision however
+    /// far it travels.  Whenever the body's center of mass is more than a distance from
+    /// the origin at the end of a step, the origin moves to it.  Positions held outside
+    /// the universe, such as in scheduled actions, are not updated.
+    /// @param anchor The body to follow, or nullptr to leave the origin where it is.
+    void set_floating_origin(Body_ptr anchor, double distance);
+
+    /// Choose how gravity between bodies is evaluated.  The default is full precision.
+    void set_precision(Precision precision);
+    Precision precision() const;
+    /// Choose how positions, velocities and the time are summed.  Applies to bodies
+    /// already in the universe and ones added later.  The default is plain.
+    void set_summation(Summation summation);
+    Summation summation() const;
+
+    /// Turn monitoring of the conserved quantities on or off.  When on, they're taken
+    /// halfway through each step, where gravity is evaluated, with the velocities from
+    /// before gravity is applied.  A step split at a scheduled action counts as two.
+    /// The potential energy is summed in the same pass as gravity, and the rest takes
+    /// one pass over the bodies.  In full precision that costs a few percent at most,
+    /// which bench-gravity can't tell from timing noise.  In mixed precision the
+    /// potential adds a load and a store to every pair, and steps take roughly 10% to
+    /// 30% longer.
+    void set_diagnostics(bool on);
+    /// @return The totals halfway through the most recent step.
+    Diagnostics const& diagnostics() const;
+    /// @return The change in each total over the most recent step, with time as the
+    /// step's length.  Zero until two steps have been monitored.
+    Diagnostics drift() const;
 
 private:
+    friend class Checkpoint;
+
+    /// Apply gravity, move the bodies, and handle collisions.
+    void advance(double time);
+
     bool m_handle_collision{true};
     double m_time{0.0};
+    /// The rounding error of m_time for compensated summation.
+    double m_time_error{0.0};
     std::list<Body_ptr> m_body;
+    /// The bodies that are worlds, which may have atmospheres and gravity fields.
+    std::vector<std::shared_ptr<World>> m_worlds;
+    std::multimap<double, Action> m_actions;
+    std::vector<std::pair<Condition, Action>> m_watches;
+    V3 m_origin{V0};
+    /// The body the origin follows, if any.
+    Body_ptr m_anchor;
+    double m_rebase_distance{0.0};
+    Precision m_precision{Precision::full};
+    Summation m_summation{Summation::plain};
+    bool m_diagnose{false};
+    /// The number of steps monitored, up to 2.
+    int m_diagnosed{0};
+    Diagnostics m_diagnostics;
+    Diagnostics m_previous_diagnostics;
+    Mixed_Gravity m_mixed_gravity;
 };
 
 #endif // LOFT_LOFTLIB_UNIVERSE_HH_INCLUDED
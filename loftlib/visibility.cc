@@ -0,0 +1,300 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "parallel.hh"
+#include "trajectory.hh"
+#include "visibility.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+
+/// @return The index of the frame that starts the interval holding a time.  Times outside
+/// the trajectory use the first or last interval.
+static std::size_t interval(Trajectory_Reader const& trajectory, double time)
+{
+    return std::min(trajectory.find(time), trajectory.frames() - 2);
+}
+
+/// @return The rate of change of a body's position at a frame from the positions at that
+/// frame and its neighbors.  Recorded velocities aren't used, so the curve is consistent
+/// with the recorded positions however they were integrated.
+static V3 tangent(Trajectory_Reader const& trajectory, std::size_t k, std::size_t i)
+{
+    auto const n{trajectory.frames()};
+    if (n == 2)
+        return (trajectory.frame(1).r(i) - trajectory.frame(0).r(i))
+            /(trajectory.frame(1).time - trajectory.frame(0).time);
+    // Differentiate the parabola through three frames, centered where possible.
+    auto j{std::clamp<std::size_t>(k, 1, n - 2)};
+    auto f0{trajectory.frame(j - 1)};
+    auto f1{trajectory.frame(j)};
+    auto f2{trajectory.frame(j + 1)};
+    auto t{trajectory.frame(k).time};
+    auto d0{(2*t - f1.time - f2.time)/((f0.time - f1.time)*(f0.time - f2.time))};
+    auto d1{(2*t - f0.time - f2.time)/((f1.time - f0.time)*(f1.time - f2.time))};
+    auto d2{(2*t - f0.time - f1.time)/((f2.time - f0.time)*(f2.time - f1.time))};
+    return d0*f0.r(i) + d1*f1.r(i) + d2*f2.r(i);
+}
+
+/// @return The cubic Hermite curve through a body's positions at the ends of the interval
+/// that starts at frame k, evaluated at a time.
+static V3 hermite(Trajectory_Reader const& trajectory, std::size_t k, std::size_t i,
+                  double time)
+{
+    auto f0{trajectory.frame(k)};
+    auto f1{trajectory.frame(k + 1)};
+    auto h{f1.time - f0.time};
+    auto s{(time - f0.time)/h};
+    auto s2{s*s};
+    auto s3{s2*s};
+    return (2*s3 - 3*s2 + 1)*f0.r(i) + ((s3 - 2*s2 + s)*h)*tangent(trajectory, k, i)
+        + (3*s2 - 2*s3)*f1.r(i) + ((s3 - s2)*h)*tangent(trajectory, k + 1, i);
+}
+
+/// Find where a function changes sign by false position with the Illinois modification,
+/// which keeps both ends of the bracket moving.
+/// @param lo, hi A bracket where the function has opposite signs at the ends.
+static double root(std::function<double(double)> const& f, double lo, double hi,
+                   double tolerance)
+{
+    auto f_lo{f(lo)};
+    auto f_hi{f(hi)};
+    int side{0};
+    for (int i{0}; i < 200 && hi - lo > tolerance; ++i)
+    {
+        auto t{(lo*f_hi - hi*f_lo)/(f_hi - f_lo)};
+        // Don't get stuck on one end.
+        t = std::clamp(t, lo + 0.25*tolerance, hi - 0.25*tolerance);
+        auto f_t{f(t)};
+        if ((f_t > 0.0) == (f_hi > 0.0))
+        {
+            hi = t;
+            f_hi = f_t;
+            if (side == 1)
+                f_lo *= 0.5;
+            side = 1;
+        }
+        else
+        {
+            lo = t;
+            f_lo = f_t;
+            if (side == -1)
+                f_hi *= 0.5;
+            side = -1;
+        }
+    }
+    return 0.5*(lo + hi);
+}
+
+/// Find the maximum of a function with one peak in an interval by golden-section search.
+/// @return The time and value of the maximum.
+static std::tuple<double, double> peak(std::function<double(double)> const& f, double lo,
+                                       double hi, double tolerance)
+{
+    double const g{0.5*(std::sqrt(5.0) - 1.0)};
+    auto t1{hi - g*(hi - lo)};
+    auto t2{lo + g*(hi - lo)};
+    auto f1{f(t1)};
+    auto f2{f(t2)};
+    while (hi - lo > tolerance)
+    {
+        if (f1 < f2)
+        {
+            lo = t1;
+            t1 = t2;
+            f1 = f2;
+            t2 = lo + g*(hi - lo);
+            f2 = f(t2);
+        }
+        else
+        {
+            hi = t2;
+            t2 = t1;
+            f2 = f1;
+            t1 = hi - g*(hi - lo);
+            f1 = f(t1);
+        }
+    }
+    auto t{0.5*(lo + hi)};
+    return {t, f(t)};
+}
+
+Visibility::Visibility(Trajectory_Reader const& trajectory, std::size_t world,
+                       double radius)
+    : m_trajectory{trajectory},
+      m_world{world},
+      m_radius{radius}
+{
+    assert(m_trajectory.frames() >= 2);
+    assert(m_world < m_trajectory.bodies());
+}
+
+double Visibility::start() const
+{
+    return m_trajectory.frame(0).time;
+}
+
+double Visibility::end() const
+{
+    return m_trajectory.frame(m_trajectory.frames() - 1).time;
+}
+
+V3 Visibility::position(std::size_t body, double time) const
+{
+    return hermite(m_trajectory, interval(m_trajectory, time), body, time);
+}
+
+std::tuple<V3, M3> Visibility::world_frame(double time) const
+{
+    auto k{interval(m_trajectory, time)};
+    auto f0{m_trajectory.frame(k)};
+    auto f1{m_trajectory.frame(k + 1)};
+    auto s{(time - f0.time)/(f1.time - f0.time)};
+    return {hermite(m_trajectory, k, m_world, time),
+            slerp(f0.orientation(m_world), f1.orientation(m_world), s)};
+}
+
+V3 Visibility::fixed(std::size_t body, double time) const
+{
+    auto [c, o] = world_frame(time);
+    return tr(o)*(position(body, time) - c);
+}
+
+std::tuple<double, double, double> Visibility::location(std::size_t body,
+                                                        double time) const
+{
+    auto p{fixed(body, time)};
+    auto r_xy{std::sqrt(p.x*p.x + p.y*p.y)};
+    return {std::atan2(p.z, r_xy), std::atan2(-p.x, p.y), mag(p) - m_radius};
+}
+
+/// @return The unit vector from the world's center toward a station in the world's
+/// frame.  Zero longitude is in the y-direction.
+static V3 up(Station const& station)
+{
+    auto cos_lat{std::cos(station.lat)};
+    return {-cos_lat*std::sin(station.lon), cos_lat*std::cos(station.lon),
+            std::sin(station.lat)};
+}
+
+double Visibility::elevation(std::size_t body, Station const& station, double time) const
+{
+    auto u{up(station)};
+    auto d{fixed(body, time) - (m_radius + station.alt)*u};
+    return std::asin(dot(u, d)/mag(d));
+}
+
+std::vector<Geo_Batch>
+Visibility::ground_tracks(std::vector<std::size_t> const& satellites,
+                          std::vector<double> const& times, unsigned threads) const
+{
+    std::vector<Geo_Batch> tracks(satellites.size());
+    parallel_for(satellites.size(), [&](std::size_t i) {
+        auto& track{tracks[i]};
+        track.resize(times.size());
+        for (std::size_t j{0}; j < times.size(); ++j)
+        {
+            auto r{position(satellites[i], times[j])};
+            track.x[j] = r.x;
+            track.y[j] = r.y;
+            track.z[j] = r.z;
+            std::tie(track.lat[j], track.lon[j], track.alt[j])
+                = location(satellites[i], times[j]);
+        }
+    }, threads);
+    return tracks;
+}
+
+std::vector<Pass> Visibility::passes(std::vector<std::size_t> const& satellites,
+                                     std::vector<Station> const& stations,
+                                     double tolerance, unsigned threads) const
+{
+    std::vector<std::vector<Pass>> pairs(satellites.size()*stations.size());
+    parallel_for(pairs.size(), [&](std::size_t i) {
+        auto station{i % stations.size()};
+        pairs[i] = passes(satellites[i/stations.size()], station, stations[station],
+                          tolerance);
+    }, threads);
+    std::vector<Pass> all;
+    for (auto const& pair : pairs)
+        all.insert(all.end(), pair.begin(), pair.end());
+    return all;
+}
+
+std::vector<Pass> Visibility::passes(std::size_t satellite, std::size_t index,
+                                     Station const& station, double tolerance) const
+{
+    // Positive when the satellite is in view.  The sine of the elevation is smooth and
+    // cheaper than the elevation.
+    auto u{up(station)};
+    auto p{(m_radius + station.alt)*u};
+    auto sin_min{std::sin(station.min_elevation)};
+    auto g{[&](double t) {
+        auto d{fixed(satellite, t) - p};
+        return dot(u, d)/mag(d) - sin_min;
+    }};
+
+    std::vector<Pass> passes;
+    auto rise{start()};
+    auto in_view{g(rise) > 0.0};
+    auto cross{[&](double t) {
+        if (!in_view)
+            rise = t;
+        else
+        {
+            auto [top, sin_top] = peak(g, rise, t, tolerance);
+            passes.push_back({satellite, index, rise, t, top,
+                              std::asin(std::clamp(sin_top + sin_min, -1.0, 1.0))});
+        }
+        in_view = !in_view;
+    }};
+
+    // The curves are cubic between frames, so look for crossings frame by frame.  Two
+    // crossings in one interval show up as a peak or dip between them.
+    for (std::size_t k{0}; k + 1 < m_trajectory.frames(); ++k)
+    {
+        auto a{m_trajectory.frame(k).time};
+        auto b{m_trajectory.frame(k + 1).time};
+        auto eps{1e-3*(b - a)};
+        auto g_a{g(a)};
+        auto g_b{g(b)};
+        if ((g_a > 0.0) != (g_b > 0.0))
+            cross(root(g, a, b, tolerance));
+        else if (g_a <= 0.0 && g(a + eps) > g_a && g(b - eps) > g_b)
+        {
+            auto [top, g_top] = peak(g, a, b, tolerance);
+            if (g_top > 0.0)
+            {
+                cross(root(g, a, top, tolerance));
+                cross(root(g, top, b, tolerance));
+            }
+        }
+        else if (g_a > 0.0 && g(a + eps) < g_a && g(b - eps) < g_b)
+        {
+            auto [bottom, minus_g] = peak([&](double t) { return -g(t); }, a, b,
+                                          tolerance);
+            if (minus_g >= 0.0)
+            {
+                cross(root(g, a, bottom, tolerance));
+                cross(root(g, bottom, b, tolerance));
+            }
+        }
+    }
+    if (in_view)
+        cross(end());
+    return passes;
+}
@@ -0,0 +1,103 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOFT_LOFTLIB_VISIBILITY_HH_INCLUDED
+#define LOFT_LOFTLIB_VISIBILITY_HH_INCLUDED
+
+#include "three-vector.hh"
+#include "world.hh"
+
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+class Trajectory_Reader;
+
+/// A place on a world's surface that watches satellites.
+struct Station
+{
+    double lat; ///< rad
+    double lon; ///< rad
+    double alt{0.0}; ///< m
+    double min_elevation{0.0}; ///< Elevation where a satellite comes into view: rad
+};
+
+/// A span of time when a satellite is in view of a station.
+struct Pass
+{
+    std::size_t satellite; ///< Body index in the trajectory.
+    std::size_t station; ///< Index in the list of stations.
+    double rise; ///< s
+    double set; ///< s
+    double culmination; ///< Time of highest elevation: s
+    double max_elevation; ///< rad
+
+    friend bool operator==(Pass const& p1, Pass const& p2) = default;
+};
+
+/// Ground tracks and station passes from a recorded trajectory.  Between frames, bodies
+/// follow cubic Hermite curves through the recorded positions, and the world turns at a
+/// steady rate, so times are found by root-finding on a smooth path instead of by dense
+/// sampling.  Latitude, longitude and altitude are as in World.
+class Visibility
+{
+public:
+    /// @param trajectory A trajectory with at least two frames.  It must outlive this
+    /// object.
+    /// @param world The index of the world in the trajectory's frames.
+    /// @param radius The world's radius: m
+    Visibility(Trajectory_Reader const& trajectory, std::size_t world, double radius);
+
+    /// @return The time of the first and last frames.
+    double start() const;
+    double end() const;
+
+    /// @return A body's absolute position at a time.
+    V3 position(std::size_t body, double time) const;
+    /// @return A body's latitude, longitude and altitude at a time.
+    std::tuple<double, double, double> location(std::size_t body, double time) const;
+    /// @return A body's elevation above a station's horizon at a time: rad
+    double elevation(std::size_t body, Station const& station, double time) const;
+
+    /// @return The ground track of each satellite, sampled at the given times, with
+    /// absolute positions and latitudes, longitudes and altitudes.  Satellites are done
+    /// in parallel.
+    std::vector<Geo_Batch> ground_tracks(std::vector<std::size_t> const& satellites,
+                                         std::vector<double> const& times,
+                                         unsigned threads = 0) const;
+    /// @return Every pass of each satellite over each station during the trajectory,
+    /// sorted by satellite, then station, then time.  Passes in progress at the start
+    /// or end of the trajectory are cut off there.  Satellite-station pairs are done in
+    /// parallel.
+    /// @param tolerance How closely to find rise and set times: s
+    std::vector<Pass> passes(std::vector<std::size_t> const& satellites,
+                             std::vector<Station> const& stations,
+                             double tolerance = 1e-3, unsigned threads = 0) const;
+
+private:
+    /// @return The world's position and orientation at a time.
+    std::tuple<V3, M3> world_frame(double time) const;
+    /// @return A body's position in the world's frame at a time.
+    V3 fixed(std::size_t body, double time) const;
+    /// @return The passes of one satellite over one station.
+    std::vector<Pass> passes(std::size_t satellite, std::size_t index,
+                             Station const& station, double tolerance) const;
+
+    Trajectory_Reader const& m_trajectory;
+    std::size_t m_world;
+    double m_radius;
+};
+
+#endif // LOFT_LOFTLIB_VISIBILITY_HH_INCLUDED
@@ -13,17 +13,27 @@
 //  You should have received a copy of the GNU General Public License along with Vamos.
 //  If not, see <http://www.gnu.org/licenses/>.
 
+#include "atmosphere.hh"
+#include "ephemeris.hh"
+#include "serialize.hh"
+#include "terrain.hh"
 #include "units.hh"
 #include "world.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <numbers>
+#include <string>
+#include <utility>
 
 using namespace std::numbers;
 
 World::World(double mass, double radius, V3 const& r, V3 const& v,
              M3 const& orientation, double period)
     // The orientation matrix aligns the z-axis with omega.
-    : Body(mass, M0, r, v, orientation, orientation*(2*pi/period)*Vz),
+    : Body(mass, M0, r, v, orientation,
+           period == 0.0 ? V0 : orientation*(2*pi/period)*Vz),
       m_radius(radius)
 {
 }
@@ -35,21 +45,313 @@ double World::radius() const
 
 bool World::intersects(Body const& b) const
 {
-    return mag(b.r() - r()) < m_radius;
+    auto d{mag(b.r() - r())};
+    if (!m_terrain)
+        return d < m_radius;
+    // Only look up the terrain when the body is within the range of its heights, so
+    // bodies in orbit never map tiles.
+    if (d >= m_radius + m_terrain->max_height())
+        return false;
+    if (d < m_radius + m_terrain->min_height())
+        return true;
+    auto [lat, lon, alt] = location(b.r());
+    return alt < 0.0;
 }
 
 std::tuple<V3, M3> World::locate(double lat, double lon, double alt) const
 {
     // Zero longitude is in the y-direction to match the gluSphere texture origin.
-    auto r{transform_out(rot(rot((m_radius + alt)*Vy, lat*Vx), lon*Vz))};
+    auto d{m_radius + alt + terrain_height(lat, lon)};
+    auto r{transform_out(rot(rot(d*Vy, lat*Vx), lon*Vz))};
     // Construct the matrix for z up and x east.
     auto m{rot(rot(rot(M1, lon*Vz), (lat - pi/2)*Vx), pi*Vz)};
     return {r, orientation()*m};
 }
 
-std::tuple<double, double, double> World::location(V3 const& r)
+std::tuple<double, double, double> World::location(V3 const& r) const
 {
-    auto r_in{rotate_in(r)};
+    auto r_in{transform_in(r)};
     auto r_xy{mag(V3(r_in.x, r_in.y, 0.0))};
-    return {std::atan2(r_in.z, r_xy), std::atan2(-r_in.x, r_in.y), mag(r_in) - m_radius};
+    auto lat{std::atan2(r_in.z, r_xy)};
+    auto lon{std::atan2(-r_in.x, r_in.y)};
+    return {lat, lon, mag(r_in) - m_radius - terrain_height(lat, lon)};
+}
+
+void Geo_Batch::resize(std::size_t n)
+{
+    for (auto* column : {&x, &y, &z, &lat, &lon, &alt})
+        column->resize(n);
+}
+
+std::size_t Geo_Batch::size() const
+{
+    return x.size();
+}
+
+/// Set positions from latitudes, longitudes, and altitudes above a sphere.  The columns
+/// don't overlap, and saying so, along with passing the frame by value, keeps the frame in
+/// registers rather than reloading it after every store.
+/// @param ground Terrain heights to add to the altitudes, or nullptr.
+static void locate_columns(std::size_t n, V3 c, V3 ex, V3 ey, V3 ez, double radius,
+                           double const* __restrict lat, double const* __restrict lon,
+                           double const* __restrict alt, double const* __restrict ground,
+                           double* __restrict x, double* __restrict y,
+                           double* __restrict z)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        // Zero longitude is in the y-direction, as in locate(lat, lon, alt).
+        auto d{radius + alt[i] + (ground ? ground[i] : 0.0)};
+        auto cos_lat{std::cos(lat[i])};
+        auto px{-d*cos_lat*std::sin(lon[i])};
+        auto py{d*cos_lat*std::cos(lon[i])};
+        auto pz{d*std::sin(lat[i])};
+        x[i] = c.x + px*ex.x + py*ey.x + pz*ez.x;
+        y[i] = c.y + px*ex.y + py*ey.y + pz*ez.y;
+        z[i] = c.z + px*ex.z + py*ey.z + pz*ez.z;
+    }
+}
+
+/// Set latitudes, longitudes, and altitudes above a sphere from positions.  See
+/// locate_columns().
+static void location_columns(std::size_t n, V3 c, V3 ex, V3 ey, V3 ez, double radius,
+                             double const* __restrict x, double const* __restrict y,
+                             double const* __restrict z, double* __restrict lat,
+                             double* __restrict lon, double* __restrict alt)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto dx{x[i] - c.x};
+        auto dy{y[i] - c.y};
+        auto dz{z[i] - c.z};
+        // The axes are orthonormal, so projecting onto them transforms in.
+        auto px{dx*ex.x + dy*ex.y + dz*ex.z};
+        auto py{dx*ey.x + dy*ey.y + dz*ey.z};
+        auto pz{dx*ez.x + dy*ez.y + dz*ez.z};
+        auto r_xy{std::sqrt(px*px + py*py)};
+        lat[i] = std::atan2(pz, r_xy);
+        lon[i] = std::atan2(-px, py);
+        alt[i] = std::sqrt(r_xy*r_xy + pz*pz) - radius;
+    }
+}
+
+void World::locate(Geo_Batch& b) const
+{
+    auto const n{b.size()};
+    std::vector<double> heights;
+    if (m_terrain)
+    {
+        heights.resize(n);
+        for (std::size_t i = 0; i < n; ++i)
+            heights[i] = m_terrain->height(b.lat[i], b.lon[i]);
+    }
+    // The world's origin and axes in absolute coordinates.
+    locate_columns(n, transform_out(V0), rotate_out(Vx), rotate_out(Vy), rotate_out(Vz),
+                   m_radius, b.lat.data(), b.lon.data(), b.alt.data(),
+                   m_terrain ? heights.data() : nullptr, b.x.data(), b.y.data(),
+                   b.z.data());
+}
+
+void World::location(Geo_Batch& b) const
+{
+    auto const n{b.size()};
+    location_columns(n, transform_out(V0), rotate_out(Vx), rotate_out(Vy),
+                     rotate_out(Vz), m_radius, b.x.data(), b.y.data(), b.z.data(),
+                     b.lat.data(), b.lon.data(), b.alt.data());
+    if (m_terrain)
+        for (std::size_t i = 0; i < n; ++i)
+            b.alt[i] -= m_terrain->height(b.lat[i], b.lon[i]);
+}
+
+void World::set_terrain(std::shared_ptr<Terrain const> terrain)
+{
+    m_terrain = std::move(terrain);
+}
+
+Terrain const* World::terrain() const
+{
+    return m_terrain.get();
+}
+
+double World::terrain_height(double lat, double lon) const
+{
+    return m_terrain ? m_terrain->height(lat, lon) : 0.0;
+}
+
+void World::set_atmosphere(std::shared_ptr<Atmosphere const> atmosphere)
+{
+    m_atmosphere = std::move(atmosphere);
+}
+
+Atmosphere const* World::atmosphere() const
+{
+    return m_atmosphere.get();
+}
+
+V3 World::drag(Body const& body, double time) const
+{
+    if (!m_atmosphere)
+        return V0;
+    auto r{body.r_cm() - r_cm()};
+    auto altitude{mag(r) - m_radius};
+    if (altitude >= m_atmosphere->top())
+        return V0;
+    // The air moves with the surface.
+    auto v{body.v_cm() - v_cm() - cross(omega(), r)};
+    auto m{body.m()};
+    auto k{std::min(0.5*m_atmosphere->density(altitude)*body.drag_area()*mag(v)*time, m)};
+    return -k*v;
+}
+
+void World::set_harmonics(std::shared_ptr<Harmonics const> harmonics, std::size_t degree,
+                          std::size_t order)
+{
+    m_harmonics = std::move(harmonics);
+    m_degree = m_harmonics ? std::min(degree, m_harmonics->degree()) : 0;
+    m_order = std::min(order, m_degree);
+}
+
+Harmonics const* World::harmonics() const
+{
+    return m_harmonics.get();
+}
+
+std::size_t World::harmonics_degree() const
+{
+    return m_degree;
+}
+
+std::size_t World::harmonics_order() const
+{
+    return m_order;
+}
+
+V3 World::perturbation(V3 const& r) const
+{
+    if (!m_harmonics || m_degree < 2)
+        return V0;
+    // The field's x-axis is at zero longitude, which is the world's y-axis.
+    auto r_in{rotate_in(r - this->r())};
+    auto a{m_harmonics->acceleration({r_in.y, -r_in.x, r_in.z}, consts::G*m(),
+                                     m_degree, m_order, m_work)};
+    return rotate_out({-a.y, a.x, a.z});
+}
+
+void World::follow(std::shared_ptr<Ephemeris const> ephemeris, double time)
+{
+    m_ephemeris = std::move(ephemeris);
+    m_ephemeris_time = time;
+    if (!m_ephemeris)
+        return;
+    place();
+}
+
+Ephemeris const* World::ephemeris() const
+{
+    return m_ephemeris.get();
+}
+
+bool World::is_scripted() const
+{
+    return m_ephemeris != nullptr;
+}
+
+void World::step(double time)
+{
+    Body::step(time);
+    if (!m_ephemeris)
+        return;
+    m_ephemeris_time += time;
+    if (m_ephemeris_time > m_ephemeris->end())
+    {
+        m_ephemeris.reset();
+        return;
+    }
+    place();
+}
+
+void World::rebase(V3 const& offset)
+{
+    Body::rebase(offset);
+    m_origin += offset;
+}
+
+void World::set_origin(V3 const& origin)
+{
+    m_origin = origin;
+    if (m_ephemeris)
+        place();
+}
+
+void World::place()
+{
+    // Put the center of mass on the path.  Captured bodies move with the world.
+    set_r(r() + m_ephemeris->position(m_ephemeris_time) - m_origin - r_cm());
+    set_v(m_ephemeris->velocity(m_ephemeris_time));
+}
+
+void World::save(std::ostream& os) const
+{
+    Body::save(os);
+    serialize::write(os, m_radius);
+    // Terrain is saved as the path of its file.
+    auto path{m_terrain ? m_terrain->path() : std::string()};
+    serialize::write(os, static_cast<std::uint64_t>(path.size()));
+    os.write(path.data(), path.size());
+    // Only the standard atmosphere can be saved.
+    serialize::write(os, static_cast<std::uint8_t>(m_atmosphere != nullptr));
+    // Likewise, only the Earth's gravity field.
+    serialize::write(os, static_cast<std::uint8_t>(m_harmonics != nullptr));
+    serialize::write(os, static_cast<std::uint32_t>(m_degree));
+    serialize::write(os, static_cast<std::uint32_t>(m_order));
+    serialize::write(os, m_origin);
+    serialize::write(os, static_cast<std::uint8_t>(m_ephemeris != nullptr));
+    if (m_ephemeris)
+    {
+        serialize::write(os, m_ephemeris_time);
+        m_ephemeris->save(os);
+    }
+}
+
+void World::restore(std::istream& is)
+{
+    Body::restore(is);
+    serialize::read(is, m_radius);
+    std::uint64_t length{0};
+    serialize::read(is, length);
+    m_terrain.reset();
+    // Don't trust a corrupt length.
+    if (length > 4096)
+        is.setstate(std::ios::failbit);
+    else if (length > 0 && is)
+    {
+        std::string path(length, '\0');
+        is.read(path.data(), length);
+        auto terrain{std::make_shared<Terrain const>(path)};
+        if (terrain->is_open())
+            m_terrain = terrain;
+        else
+            is.setstate(std::ios::failbit);
+    }
+    std::uint8_t atmosphere{0};
+    serialize::read(is, atmosphere);
+    m_atmosphere = atmosphere ? Atmosphere::standard() : nullptr;
+    std::uint8_t harmonics{0};
+    std::uint32_t degree{0};
+    std::uint32_t order{0};
+    serialize::read(is, harmonics);
+    serialize::read(is, degree);
+    serialize::read(is, order);
+    set_harmonics(harmonics ? Harmonics::earth() : nullptr, degree, order);
+    serialize::read(is, m_origin);
+    std::uint8_t ephemeris{0};
+    serialize::read(is, ephemeris);
+    m_ephemeris.reset();
+    if (ephemeris)
+    {
+        serialize::read(is, m_ephemeris_time);
+        m_ephemeris = Ephemeris::load(is);
+        if (!m_ephemeris)
+            is.setstate(std::ios::failbit);
+    }
 }
@@ -17,15 +17,34 @@
 #define LOFT_LOFTLIB_WORLD_HH_INCLUDED
 
 #include "body.hh"
+#include "harmonics.hh"
 
+#include <memory>
 #include <tuple>
+#include <vector>
+
+class Atmosphere;
+class Ephemeris;
+class Terrain;
+
+/// Absolute positions and geographic coordinates of many points, one column per
+/// quantity.
+struct Geo_Batch
+{
+    std::vector<double> x, y, z; ///< m
+    std::vector<double> lat, lon; ///< rad
+    std::vector<double> alt; ///< m
+
+    void resize(std::size_t n);
+    std::size_t size() const;
+};
 
 /// A large spherical body, such as a planet or moon.
 class World : public Body
 {
 public:
     /// @param period The period of rotation in seconds. units::day() can be used to
-    /// convert from days.
+    /// convert from days.  A world with a period of 0 doesn't rotate.
     World(double mass, double radius, V3 const& r, V3 const& v,
           M3 const& orientation, double period);
     virtual ~World() = default;
@@ -37,10 +56,82 @@ public:
     /// and altitude.  The orientation has z normal to the surface and y north.
     std::tuple<V3, M3> locate(double lat, double lon, double alt) const;
     /// @return Latitude, longitude, and altitude for a given position.
-    std::tuple<double, double, double> location(V3 const& r);
+    std::tuple<double, double, double> location(V3 const& r) const;
+    /// Set the positions in a batch from the latitudes, longitudes, and altitudes.
+    void locate(Geo_Batch& batch) const;
+    /// Set the latitudes, longitudes, and altitudes in a batch from the positions.  The
+    /// world's frame is worked out once for the whole batch rather than for each
+    /// position.  The trig functions are called for each position, so neither batch
+    /// conversion is vectorized.
+    void location(Geo_Batch& batch) const;
+
+    /// Give the world a surface with terrain, or a smooth one if nullptr.  Altitudes in
+    /// locate() and location() are then above the terrain, and bodies intersect the
+    /// world where they're below it.
+    void set_terrain(std::shared_ptr<Terrain const> terrain);
+    /// @return The world's terrain, or nullptr if it has none.
+    Terrain const* terrain() const;
+    /// @return The height of the surface above the radius at a latitude and longitude.
+    double terrain_height(double lat, double lon) const;
+
+    /// Give the world an atmosphere, or none if nullptr.  The atmosphere rotates with the
+    /// world.
+    void set_atmosphere(std::shared_ptr<Atmosphere const> atmosphere);
+    /// @return The world's atmosphere, or nullptr if it has none.
+    Atmosphere const* atmosphere() const;
+    /// @return The impulse from the world's atmosphere on a free body over a time step.
+    /// The impulse never does more than bring the body to rest relative to the air.
+    V3 drag(Body const& body, double time) const;
+
+    /// Give the world a non-spherical gravity field, or none if nullptr.  The field
+    /// rotates with the world.
+    /// @param degree, order The highest terms to evaluate.  Higher is more accurate and
+    /// slower.  They're clamped to the field's degree.  Degree 0 or 1 turns the field
+    /// off.
+    void set_harmonics(std::shared_ptr<Harmonics const> harmonics, std::size_t degree,
+                       std::size_t order);
+    /// @return The world's gravity field, or nullptr if it has none.
+    Harmonics const* harmonics() const;
+    /// @return The degree and order of the terms that are evaluated.
+    std::size_t harmonics_degree() const;
+    std::size_t harmonics_order() const;
+    /// @return The acceleration at an absolute position from the world's departure from
+    /// a point mass.
+    V3 perturbation(V3 const& r) const;
+
+    /// Move along an ephemeris instead of integrating.  Forces on the world are ignored.
+    /// At the end of the ephemeris the world stops following it and carries on from its
+    /// last position and velocity.  The world still rotates.
+    /// @param time The ephemeris time that corresponds to now.
+    void follow(std::shared_ptr<Ephemeris const> ephemeris, double time);
+    /// @return The ephemeris the world is following, or nullptr if it's integrated.
+    Ephemeris const* ephemeris() const;
+    virtual bool is_scripted() const override;
+    virtual void step(double time) override;
+    virtual void rebase(V3 const& offset) override;
+    /// Set the absolute position of the universe's origin.  Called when the world is
+    /// added to a universe.
+    void set_origin(V3 const& origin);
+
+    virtual void save(std::ostream& os) const override;
+    virtual void restore(std::istream& is) override;
 
 private:
+    /// Move to the current position and velocity on the ephemeris.
+    void place();
+
     double m_radius;
+    std::shared_ptr<Terrain const> m_terrain;
+    std::shared_ptr<Atmosphere const> m_atmosphere;
+    std::shared_ptr<Harmonics const> m_harmonics;
+    std::size_t m_degree{0};
+    std::size_t m_order{0};
+    mutable Harmonics::Workspace m_work;
+    std::shared_ptr<Ephemeris const> m_ephemeris;
+    /// The current time on the ephemeris.
+    double m_ephemeris_time{0.0};
+    /// Where the universe's origin is in the ephemeris's coordinates.
+    V3 m_origin{V0};
 };
 
 #endif // LOFT_LOFTLIB_WORLD_HH_INCLUDED
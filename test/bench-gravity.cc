@@ -0,0 +1,86 @@
+#include "body.hh"
+#include "universe.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Compare the speed and accuracy of gravity in full and mixed precision.  For each size
+// of a cloud of bodies, print the pairs evaluated per second in each mode, the largest
+// error in the mixed-precision velocity changes relative to full precision, and the
+// extra time taken in each mode with diagnostics on.
+
+/// @return A cloud of bodies at rest with different masses, far from the origin.
+static std::shared_ptr<Universe> cloud(std::size_t n, Universe::Precision precision)
+{
+    auto all{std::make_shared<Universe>(false)};
+    all->set_precision(precision);
+    V3 const center{4e8, -1e8, 2e7};
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        V3 r{1e4*std::sin(1.3*i), 1e4*std::cos(2.1*i), 1e4*std::sin(0.7*i + 0.2)};
+        all->add(std::make_shared<Body>(1e10*(1.0 + 1e-3*i), M1, center + r, V0, M1, V0));
+    }
+    return all;
+}
+
+/// @return The seconds per step.
+static double time_steps(Universe& all, int steps)
+{
+    auto start{std::chrono::steady_clock::now()};
+    for (int i = 0; i < steps; ++i)
+        all.step(1e-3);
+    std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+    return elapsed.count()/steps;
+}
+
+int main()
+{
+    std::cout << std::setw(6) << "bodies" << std::setw(16) << "full pairs/s"
+              << std::setw(16) << "mixed pairs/s" << std::setw(10) << "speedup"
+              << std::setw(14) << "max error" << std::setw(12) << "full diag"
+              << std::setw(12) << "mixed diag" << std::endl;
+    for (std::size_t n : {100, 300, 1000, 3000})
+    {
+        auto steps{static_cast<int>(std::max<std::size_t>(1, 30000000/(n*n)))};
+        auto full{cloud(n, Universe::Precision::full)};
+        auto mixed{cloud(n, Universe::Precision::mixed)};
+        auto full_diag{cloud(n, Universe::Precision::full)};
+        auto mixed_diag{cloud(n, Universe::Precision::mixed)};
+        full_diag->set_diagnostics(true);
+        mixed_diag->set_diagnostics(true);
+        // Take the best of several interleaved runs so that the differences with
+        // diagnostics on aren't lost in the timing noise.
+        auto t_full{1e9};
+        auto t_mixed{1e9};
+        auto t_full_diag{1e9};
+        auto t_mixed_diag{1e9};
+        for (int run = 0; run < 5; ++run)
+        {
+            t_full = std::min(t_full, time_steps(*full, steps));
+            t_full_diag = std::min(t_full_diag, time_steps(*full_diag, steps));
+            t_mixed = std::min(t_mixed, time_steps(*mixed, steps));
+            t_mixed_diag = std::min(t_mixed_diag, time_steps(*mixed_diag, steps));
+        }
+
+        double max_error{0.0};
+        for (auto it1{full->bodies().begin()}, it2{mixed->bodies().begin()};
+             it1 != full->bodies().end(); ++it1, ++it2)
+        {
+            auto v{(*it1)->v_cm()};
+            max_error = std::max(max_error, mag((*it2)->v_cm() - v)/mag(v));
+        }
+        auto pairs{0.5*n*(n - 1)};
+        std::cout << std::setw(6) << n << std::setw(16) << std::setprecision(3)
+                  << pairs/t_full << std::setw(16) << pairs/t_mixed << std::setw(10)
+                  << t_full/t_mixed << std::setw(14) << max_error << std::setw(11)
+                  << std::fixed << std::setprecision(1)
+                  << 100*(t_full_diag/t_full - 1) << '%' << std::setw(11)
+                  << 100*(t_mixed_diag/t_mixed - 1) << '%' << std::defaultfloat
+                  << std::endl;
+    }
+}
@@ -0,0 +1,100 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "atmosphere.hh"
+#include "test.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <cmath>
+#include <memory>
+
+using namespace consts;
+
+TEST_CASE("standard atmosphere")
+{
+    auto air{Atmosphere::standard()};
+    CHECK(air == Atmosphere::standard());
+    // Values from the 1976 standard's tables.
+    CHECK(air->density(0.0) == doctest::Approx(1.225).epsilon(1e-4));
+    CHECK(air->temperature(0.0) == doctest::Approx(288.15).epsilon(1e-6));
+    CHECK(air->pressure(0.0) == doctest::Approx(101325).epsilon(1e-4));
+    CHECK(air->density(10e3) == doctest::Approx(0.41351).epsilon(1e-4));
+    CHECK(air->temperature(10e3) == doctest::Approx(223.252).epsilon(1e-4));
+    CHECK(air->density(25e3) == doctest::Approx(4.0084e-2).epsilon(1e-3));
+    CHECK(air->density(50e3) == doctest::Approx(1.0269e-3).epsilon(1e-3));
+    CHECK(air->temperature(50e3) == doctest::Approx(270.65).epsilon(1e-6));
+    CHECK(air->density(80e3) == doctest::Approx(1.846e-5).epsilon(1e-3));
+    CHECK(air->density(200e3) == doctest::Approx(2.789e-10).epsilon(1e-3));
+    CHECK(air->density(400e3) == doctest::Approx(3.725e-12).epsilon(1e-3));
+    // Above the layers, the kinetic temperature rises toward 1000 K.
+    CHECK(air->temperature(88e3) == doctest::Approx(186.87).epsilon(1e-3));
+    CHECK(air->temperature(100e3) == doctest::Approx(195.08).epsilon(1e-4));
+    CHECK(air->temperature(115e3) == doctest::Approx(300.0).epsilon(1e-4));
+    CHECK(air->temperature(120e3) == doctest::Approx(360.0).epsilon(1e-4));
+    CHECK(air->temperature(500e3) == doctest::Approx(999.24).epsilon(1e-4));
+    // Pressure isn't given where the air's composition changes.
+    CHECK(air->pressure(85e3) > 0.0);
+    CHECK(std::isnan(air->pressure(86e3)));
+    CHECK(std::isnan(air->pressure(200e3)));
+    // Between samples, and at the ends.
+    CHECK(air->density(10'050.0) < air->density(10e3));
+    CHECK(air->density(10'050.0) > air->density(10'100.0));
+    CHECK(air->density(-100.0) == air->density(0.0));
+    CHECK(air->density(air->top()) == 0.0);
+    CHECK(air->density(2*air->top()) == 0.0);
+}
+
+TEST_CASE("drag")
+{
+    auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, M1, units::day(1.0))};
+    earth->set_atmosphere(Atmosphere::standard());
+    auto r{(r_earth + 1e4)*Vx};
+    // Moving with the air.
+    auto ground{cross(earth->omega(), r)};
+    auto still{std::make_shared<Body>(100.0, M1, r, ground, M1, V0)};
+    auto moving{std::make_shared<Body>(100.0, M1, r, ground + 300.0*Vz, M1, V0)};
+    // Drag can't push a body backwards through the air.
+    auto light{std::make_shared<Body>(1e-3, M1, r, ground + 300.0*Vz, M1, V0)};
+    auto no_area{std::make_shared<Body>(100.0, M1, r, ground + 300.0*Vz, M1, V0)};
+    for (auto body : {still, moving, light})
+        body->set_drag_area(0.5);
+
+    double const dt{1.0};
+    CHECK(earth->drag(*still, dt) == V0);
+    auto imp{earth->drag(*moving, dt)};
+    CHECK(imp.z == doctest::Approx(-0.5*0.41351*0.5*300.0*300.0*dt).epsilon(1e-4));
+    CHECK(close(earth->drag(*light, dt), -1e-3*300.0*Vz, 1e-12));
+    CHECK(earth->drag(*no_area, dt) == V0);
+
+    // The universe applies drag to free bodies.
+    Universe all(false);
+    all.add(earth);
+    all.add(moving);
+    all.add(no_area);
+    auto v_moving{moving->v_cm()};
+    auto v_no_area{no_area->v_cm()};
+    all.step(dt);
+    // Gravity changes the speed slightly before drag is applied.
+    CHECK((moving->v_cm() - v_moving).z == doctest::Approx(imp.z/100.0).epsilon(1e-3));
+    CHECK(moving->v_cm().z < no_area->v_cm().z);
+    // Without a drag area, only gravity halfway through the step changes the velocity.
+    auto r_half{r + 0.5*dt*v_no_area};
+    auto g{-G*m_earth*r_half/std::pow(mag(r_half), 3)};
+    CHECK(close(no_area->v_cm(), v_no_area + g*dt, 1e-9));
+}
@@ -362,6 +362,84 @@ TEST_CASE("2-point rotate and translate")
     CHECK(b2->omega() == w*Vy);
 }
 
+TEST_CASE("cached totals")
+{
+    // A chain of parts.  Changing a part deep in the chain updates the totals at the top
+    // to exactly what a chain built with the new values has.
+    auto build = [](double mass, V3 const& r, M3 const& inertia) {
+        auto top = std::make_shared<Body>(2.0, M1, 6*Vz, V0, My, V0);
+        auto middle = std::make_shared<Body>(3.0, M1, 2*Vz, V0, Myz, V0);
+        auto bottom = std::make_shared<Body>(mass, inertia, r, V0, M1, V0);
+        top->capture(middle);
+        middle->capture(bottom);
+        return std::vector<Body_Ptr>{top, middle, bottom};
+    };
+    auto chain = build(1.0, -Vz, M1);
+    auto& top = *chain[0];
+    auto& bottom = *chain[2];
+    top.m();
+    top.r_cm();
+    top.I();
+
+    SUBCASE("mass")
+    {
+        bottom.set_mass(4.0);
+        auto expected = build(4.0, -Vz, M1);
+        CHECK(top.m() == expected[0]->m());
+        CHECK(top.r_cm() == expected[0]->r_cm());
+        CHECK(top.I() == expected[0]->I());
+    }
+    SUBCASE("position")
+    {
+        auto r = bottom.r();
+        bottom.set_r(r + Vx);
+        auto expected = build(1.0, -Vz, M1);
+        expected[2]->set_r(r + Vx);
+        CHECK(top.m() == 6.0);
+        CHECK(top.r_cm() == expected[0]->r_cm());
+        CHECK(top.I() == expected[0]->I());
+        CHECK(top.r_cm() != build(1.0, -Vz, M1)[0]->r_cm());
+    }
+    SUBCASE("inertia")
+    {
+        bottom.set_inertia(2*M1);
+        auto expected = build(1.0, -Vz, 2*M1);
+        CHECK(top.r_cm() == expected[0]->r_cm());
+        CHECK(top.I() == expected[0]->I());
+        CHECK(top.I() != build(1.0, -Vz, M1)[0]->I());
+    }
+    SUBCASE("turn")
+    {
+        // The parts' inertias are in the absolute frame, so they change when their
+        // captor turns.
+        bottom.I();
+        chain[1]->I();
+        top.set_orientation(Mz);
+        auto expected = build(1.0, -Vz, M1);
+        expected[0]->set_orientation(Mz);
+        CHECK(top.I() == expected[0]->I());
+        CHECK(chain[1]->I() == expected[1]->I());
+        CHECK(bottom.I() == expected[2]->I());
+        CHECK(chain[1]->I() != build(1.0, -Vz, M1)[1]->I());
+    }
+    SUBCASE("move")
+    {
+        // Moving without turning doesn't change the inertia.
+        auto expected = top.I();
+        top.set_v(Vx);
+        top.step(1.0);
+        CHECK(top.r() == 6*Vz + Vx);
+        CHECK(top.I() == expected);
+    }
+    SUBCASE("release")
+    {
+        chain[1]->release(chain[2]);
+        CHECK(top.m() == 5.0);
+        CHECK(bottom.m() == 1.0);
+        CHECK(bottom.I() == M1);
+    }
+}
+
 // TEST_CASE("3-point")
 // {
 //     auto b1 = std::make_shared<Body>(2.0, M1, 1*Vx, 6*Vx, My, V0);
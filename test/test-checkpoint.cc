@@ -0,0 +1,140 @@
+#include "atmosphere.hh"
+#include "body.hh"
+#include "checkpoint.hh"
+#include "ephemeris.hh"
+#include "harmonics.hh"
+#include "rocket.hh"
+#include "test.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <cstdio>
+#include <sstream>
+#include <vector>
+
+using namespace consts;
+
+/// @return The universe's bodies in order.
+std::vector<std::shared_ptr<Body>> bodies(Universe const& all)
+{
+    return {all.bodies().begin(), all.bodies().end()};
+}
+
+void check_same(Universe const& u1, Universe const& u2)
+{
+    CHECK(u1.time() == u2.time());
+    auto b1{bodies(u1)};
+    auto b2{bodies(u2)};
+    REQUIRE(b1.size() == b2.size());
+    for (std::size_t i = 0; i < b1.size(); ++i)
+    {
+        CHECK(b1[i]->m() == b2[i]->m());
+        CHECK(b1[i]->r() == b2[i]->r());
+        CHECK(b1[i]->v_cm() == b2[i]->v_cm());
+        CHECK(b1[i]->orientation() == b2[i]->orientation());
+        CHECK(b1[i]->omega() == b2[i]->omega());
+        CHECK(b1[i]->is_free() == b2[i]->is_free());
+        CHECK(b1[i]->drag_area() == b2[i]->drag_area());
+    }
+}
+
+TEST_CASE("checkpoint")
+{
+    auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, rot(M1, 0.4*Vy),
+                                       units::day(1.0))};
+    auto moon{std::make_shared<World>(m_moon, r_moon, 4e8*Vx, 1e3*Vy, M1, units::day(27))};
+    auto [r_pad, m] = earth->locate(0.5, -1.4, 1);
+    auto rocket{std::make_shared<Rocket>(10, 50, 0.5, 10, 1.2, 8.0e4, 0.01, r_pad, m)};
+    auto sat{std::make_shared<Body>(1e3, M1, 2*r_earth*Vy, 5.6e3*Vx, M1, 1e-3*Vz)};
+    earth->set_atmosphere(Atmosphere::standard());
+    earth->set_harmonics(Harmonics::earth(), 4, 2);
+    {
+        // Script the moon's path.
+        auto path{std::make_shared<Body>(m_moon, M1, moon->r(), moon->v_cm(), M1, V0)};
+        Universe scratch(false);
+        scratch.add(path);
+        moon->follow(Ephemeris::fit(scratch, {path}, 100.0, 10.0, 4, 1.0)[0], 0.0);
+    }
+    rocket->set_drag_area(0.4);
+    auto all{std::make_shared<Universe>(true)};
+    for (auto b : std::vector<std::shared_ptr<Body>>{earth, moon, rocket, sat})
+        all->add(b);
+    // Keep the origin near the rocket.  The moon's ephemeris stays in the original
+    // coordinates.
+    all->set_floating_origin(rocket, 100.0);
+    all->set_summation(Universe::Summation::compensated);
+    earth->capture(rocket);
+    rocket->throttle(1.0);
+    for (int i = 0; i < 20; ++i)
+        all->step(0.1);
+    earth->release(rocket);
+    rocket->orient_thrust(1e-4*Vx);
+    for (int i = 0; i < 20; ++i)
+        all->step(0.1);
+
+    std::stringstream ss;
+    REQUIRE(Checkpoint::save(*all, ss));
+    auto copy{Checkpoint::load(ss)};
+    REQUIRE(copy);
+    check_same(*all, *copy);
+    CHECK(all->origin() != V0);
+    CHECK(copy->origin() == all->origin());
+    CHECK(copy->summation() == Universe::Summation::compensated);
+    CHECK(bodies(*copy)[3]->is_compensated());
+    CHECK(close(moon->r_cm() + all->origin(), moon->ephemeris()->position(all->time()),
+                1e-6));
+    CHECK(std::dynamic_pointer_cast<Rocket>(bodies(*copy)[2])->fuel_volume()
+          == rocket->fuel_volume());
+    CHECK(std::dynamic_pointer_cast<World>(bodies(*copy)[0])->atmosphere());
+    CHECK(!std::dynamic_pointer_cast<World>(bodies(*copy)[1])->atmosphere());
+    CHECK(std::dynamic_pointer_cast<World>(bodies(*copy)[0])->harmonics_degree() == 4);
+    CHECK(std::dynamic_pointer_cast<World>(bodies(*copy)[0])->harmonics_order() == 2);
+    CHECK(!std::dynamic_pointer_cast<World>(bodies(*copy)[1])->harmonics());
+    CHECK(std::dynamic_pointer_cast<World>(bodies(*copy)[1])->is_scripted());
+
+    SUBCASE("continue")
+    {
+        // The restored universe carries on exactly as the original does.
+        for (int i = 0; i < 50; ++i)
+        {
+            all->step(0.1);
+            copy->step(0.1);
+        }
+        check_same(*all, *copy);
+    }
+    SUBCASE("captured")
+    {
+        // Put the rocket back on the pad to check the hierarchy.
+        earth->capture(rocket);
+        std::stringstream ss2;
+        Checkpoint::save(*all, ss2);
+        auto copy2{Checkpoint::load(ss2)};
+        REQUIRE(copy2);
+        CHECK(!bodies(*copy2)[2]->is_free());
+        all->step(100.0);
+        copy2->step(100.0);
+        check_same(*all, *copy2);
+    }
+    SUBCASE("file")
+    {
+        auto path{"test-checkpoint.bin"};
+        REQUIRE(Checkpoint::save(*all, path));
+        auto copy2{Checkpoint::load(path)};
+        std::remove(path);
+        REQUIRE(copy2);
+        check_same(*all, *copy2);
+    }
+    SUBCASE("bad data")
+    {
+        auto data{ss.str()};
+        std::stringstream truncated(data.substr(0, data.size() - 1));
+        CHECK(!Checkpoint::load(truncated));
+        data[0] = 'X';
+        std::stringstream bad_magic(data);
+        CHECK(!Checkpoint::load(bad_magic));
+        CHECK(!Checkpoint::load("no-such-checkpoint.bin"));
+    }
+}
@@ -0,0 +1,89 @@
+#include "body.hh"
+#include "compressed-trajectory.hh"
+#include "runner.hh"
+#include "test.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using namespace consts;
+
+TEST_CASE("compressed trajectory")
+{
+    auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, rot(M1, 0.4*Vy),
+                                       units::day(1.0))};
+    auto moon{std::make_shared<World>(m_moon, r_moon, 4e8*Vx, 1e3*Vy, M1, units::day(27))};
+    auto [r_pad, m] = earth->locate(0.5, -1.4, 1);
+    auto pad{std::make_shared<Body>(10, M1, r_pad, V0, m, V0)};
+    auto sat{std::make_shared<Body>(1e3, M1, 2*r_earth*Vy, 5.6e3*Vx, rot(M1, 0.3*Vx),
+                                    1e-3*Vz)};
+    Universe all(false);
+    for (auto b : std::vector<std::shared_ptr<Body>>{earth, moon, pad, sat})
+        all.add(b);
+    earth->capture(pad);
+
+    auto raw_path{"test-trajectory-raw.bin"};
+    auto path{"test-trajectory.lz"};
+    Quantization quantization;
+    {
+        // Record both formats from the same run.
+        std::vector<std::unique_ptr<Trajectory_Sink>> sinks;
+        sinks.push_back(std::make_unique<Trajectory_Writer>(raw_path, 4));
+        sinks.push_back(std::make_unique<Compressed_Trajectory_Writer>(
+                            path, 4, quantization, 16));
+        Runner runner(all, 1.0);
+        for (auto& sink : sinks)
+            runner.observe([&sink](Universe& u) { sink->observe(u); });
+        runner.run(100.0);
+    }
+
+    Trajectory_Reader raw(raw_path);
+    Compressed_Trajectory_Reader reader(path);
+    REQUIRE(reader.is_open());
+    CHECK(reader.bodies() == 4);
+    REQUIRE(reader.frames() == 100);
+    // Check the frames out of order to exercise seeking.
+    for (std::size_t index : {0, 1, 2, 15, 16, 17, 99, 50, 49, 51, 52})
+    {
+        auto f1{raw.frame(index)};
+        auto f2{reader.frame(index)};
+        CHECK(f2.time == f1.time);
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            CHECK(f2.id[i] == i);
+            CHECK(close(f2.r(i), f1.r(i), 0.5*quantization.position));
+            CHECK(close(f2.v(i), f1.v(i), 0.5*quantization.velocity));
+            CHECK(close(f2.orientation(i), f1.orientation(i), 1e-8));
+        }
+    }
+    CHECK(reader.find(0.0) == 0);
+    CHECK(reader.find(50.5) == 49);
+    CHECK(reader.find(1e6) == 99);
+    CHECK(std::filesystem::file_size(path)*5 < std::filesystem::file_size(raw_path));
+
+    // Damage the index and the block count.  The footer is the last 24 bytes, and the
+    // index entries before it are 24 bytes each.
+    auto patch{[path](std::streamoff from_end, std::uint64_t value) {
+        std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+        fs.seekp(-from_end, std::ios::end);
+        fs.write(reinterpret_cast<char const*>(&value), sizeof(value));
+    }};
+    auto size{std::filesystem::file_size(path)};
+    patch(48, size);
+    CHECK(!Compressed_Trajectory_Reader(path).is_open());
+    patch(48, 8);
+    CHECK(!Compressed_Trajectory_Reader(path).is_open());
+    patch(24, UINT64_MAX/3);
+    CHECK(!Compressed_Trajectory_Reader(path).is_open());
+
+    std::remove(raw_path);
+    std::remove(path);
+    CHECK(!Compressed_Trajectory_Reader(path).is_open());
+}
@@ -0,0 +1,140 @@
+#include "body.hh"
+#include "ensemble.hh"
+#include "launch.hh"
+#include "parallel.hh"
+#include "test.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <algorithm>
+#include <numbers>
+#include <set>
+#include <stdexcept>
+
+using namespace std::numbers;
+using namespace consts;
+
+TEST_CASE("elements")
+{
+    auto mu{G*m_earth};
+    auto r{2*r_earth};
+    auto v_circ{std::sqrt(mu/r)};
+    SUBCASE("circular")
+    {
+        auto el{elements(r*Vx, v_circ*Vy, mu)};
+        CHECK(close(el.a, r, 1e-3));
+        CHECK(close(el.e, 0.0, 1e-9));
+        CHECK(close(el.i, 0.0, 1e-9));
+        CHECK(close(el.periapsis, r, 1e-3));
+        CHECK(close(el.apoapsis, r, 1e-3));
+    }
+    SUBCASE("polar ellipse")
+    {
+        // Faster than circular, so r is the periapsis.
+        auto el{elements(r*Vx, 1.2*v_circ*Vz, mu)};
+        CHECK(close(el.e, 0.44, 1e-9));
+        CHECK(close(el.i, pi/2, 1e-9));
+        CHECK(close(el.periapsis, r, 1e-3));
+        CHECK(close(el.apoapsis, r*1.44/0.56, 1e-3));
+    }
+    SUBCASE("escape")
+    {
+        auto el{elements(r*Vx, 1.5*v_circ*Vy, mu)};
+        CHECK(el.a < 0.0);
+        CHECK(el.e > 1.0);
+        CHECK(std::isinf(el.apoapsis));
+    }
+}
+
+TEST_CASE("ensemble")
+{
+    // Probes start 1000 km up with horizontal speeds.  The slow ones fall.  The last one
+    // is in a circular orbit.
+    auto r0{r_earth + 1e6};
+    auto v_circ{std::sqrt(G*m_earth/r0)};
+    auto make = [=](std::size_t i) {
+        auto v{i < 3 ? 0.2*i*v_circ : (1.0 + 0.05*(5 - i))*v_circ};
+        auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, M1, units::day(1))};
+        auto probe{std::make_shared<Body>(1e3, M1, r0*Vx, v*Vy, M1, V0)};
+        auto all{std::make_shared<Universe>(false)};
+        all->add(earth);
+        all->add(probe);
+        return Member{all, earth, probe, {}};
+    };
+    Ensemble ens(6, make);
+    std::set<std::size_t> seen;
+    ens.run(2e3, 1.0, [&](Outcome const& out) { seen.insert(out.index); }, 3);
+    CHECK(ens.size() == 6);
+    CHECK(seen.size() == 6);
+
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        auto out{ens.outcome(i)};
+        CHECK(out.impact);
+        CHECK(out.time < 2e3);
+        CHECK(close(mag(out.r), r_earth, 1e4));
+    }
+    // Circular orbit
+    auto out{ens.outcome(5)};
+    CHECK(!out.impact);
+    CHECK(out.time == doctest::Approx(2e3));
+    CHECK(close(out.orbit.a, r0, 1e4));
+    CHECK(close(out.orbit.e, 0.0, 1e-3));
+
+    auto sum{ens.summary()};
+    CHECK(sum.impacts == 3);
+    CHECK(sum.orbits == 3);
+    CHECK(sum.a.mean > r_earth);
+    CHECK(sum.a.sd > 0.0);
+    CHECK(close(sum.i.mean, 0.0, 1e-9));
+    CHECK(close(sum.lat.mean, 0.0, 1e-9));
+}
+
+TEST_CASE("parallel for")
+{
+    // Uneven work so that workers run out at different times and steal.
+    std::vector<int> count(101, 0);
+    parallel_for(count.size(), [&count](std::size_t i) {
+        volatile double x{0.0};
+        for (std::size_t k = 0; k < (i % 7)*10000; ++k)
+            x = x + 1.0;
+        ++count[i];
+    }, 4);
+    CHECK(std::all_of(count.begin(), count.end(), [](int n) { return n == 1; }));
+
+    CHECK_THROWS_AS(parallel_for(10, [](std::size_t i) {
+        if (i == 7)
+            throw std::runtime_error("7");
+    }, 3), std::runtime_error);
+}
+
+TEST_CASE("launch")
+{
+    Launch launch;
+    CHECK(launch.set("turn_time", 50.0));
+    CHECK(launch.get("turn_time") == 50.0);
+    CHECK(!launch.set("no such thing", 1.0));
+    CHECK(Launch::names().size() == 17);
+
+    auto member{launch.build()};
+    CHECK(!member.probe->is_free());
+    Ensemble ens(2, [&launch](std::size_t i) {
+        auto l{launch};
+        l.release_time = 1.0 + i;
+        return l.build();
+    });
+    ens.run(10.0, 0.1);
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        auto out{ens.outcome(i)};
+        CHECK(!out.impact);
+        CHECK(close(out.lat, launch.lat, 1e-3));
+        // Climbing
+        CHECK(mag(out.r) > r_earth + 1);
+    }
+    // The earlier launch is higher.
+    CHECK(mag(ens.outcome(0).r) > mag(ens.outcome(1).r));
+}
@@ -0,0 +1,164 @@
+#include "body.hh"
+#include "ephemeris.hh"
+#include "test.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+
+using namespace consts;
+
+struct System
+{
+    std::shared_ptr<Universe> all;
+    std::shared_ptr<World> earth;
+    std::shared_ptr<World> moon;
+};
+
+System earth_and_moon()
+{
+    auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, M1, units::day(1.0))};
+    auto moon{std::make_shared<World>(m_moon, r_moon, 3.844e8*Vx, 1.022e3*Vy, M1,
+                                      units::day(27.32))};
+    auto all{std::make_shared<Universe>(false)};
+    all->add(earth);
+    all->add(moon);
+    return {all, earth, moon};
+}
+
+TEST_CASE("straight line")
+{
+    V3 const r{1.0, 2.0, 3.0};
+    V3 const v{4.0, -5.0, 6.0};
+    auto b{std::make_shared<Body>(1.0, M1, r, v, M1, V0)};
+    Universe all(false);
+    all.add(b);
+    auto eph{Ephemeris::fit(all, {b}, 100.0, 30.0, 3, 1.0)};
+    REQUIRE(eph.size() == 1);
+    // The span is a whole number of segments.
+    CHECK(eph[0]->start() == 0.0);
+    CHECK(eph[0]->end() == 120.0);
+    CHECK(all.time() == 120.0);
+    for (auto t : {0.0, 12.5, 30.0, 77.0, 120.0})
+    {
+        CHECK(close(eph[0]->position(t), r + t*v, 1e-9));
+        CHECK(close(eph[0]->velocity(t), v, 1e-12));
+    }
+
+    // Positions are absolute even if the origin moves during the fit.
+    auto moved{std::make_shared<Body>(1.0, M1, r, v, M1, V0)};
+    Universe rebased(false);
+    rebased.add(moved);
+    rebased.rebase(V3(-500.0, 0.0, 0.0));
+    rebased.set_floating_origin(moved, 10.0);
+    auto moved_eph{Ephemeris::fit(rebased, {moved}, 100.0, 30.0, 3, 1.0)};
+    CHECK(rebased.origin() != V3(-500.0, 0.0, 0.0));
+    for (auto t : {0.0, 12.5, 30.0, 77.0, 120.0})
+        CHECK(close(moved_eph[0]->position(t), r + t*v, 1e-9));
+
+    // A world added after the origin moved follows the ephemeris in absolute terms.
+    auto world{std::make_shared<World>(1.0, 1.0, V0, V0, M1, 0.0)};
+    world->follow(eph[0], 0.0);
+    rebased.add(world);
+    CHECK(close(rebased.origin() + world->r_cm(), r, 1e-9));
+    rebased.step(10.0);
+    CHECK(close(rebased.origin() + world->r_cm(), r + 10.0*v, 1e-9));
+}
+
+TEST_CASE("fit")
+{
+    auto fitted{earth_and_moon()};
+    auto eph{Ephemeris::fit(*fitted.all, {fitted.earth, fitted.moon}, units::day(4.0),
+                            units::day(0.5), 10, 60.0)};
+    REQUIRE(eph.size() == 2);
+
+    // Compare with a run at the same step size.
+    auto ref{earth_and_moon()};
+    for (int i{1}; i <= 96; ++i)
+    {
+        for (int j{0}; j < 60; ++j)
+            ref.all->step(60.0);
+        auto t{ref.all->time()};
+        CHECK(close(eph[1]->position(t), ref.moon->r_cm(), 1e3));
+        // Velocities are fitted less closely than positions.
+        CHECK(close(eph[1]->velocity(t), ref.moon->v_cm(), 0.1));
+        CHECK(close(eph[0]->position(t), ref.earth->r_cm(), 20.0));
+    }
+
+    SUBCASE("save and load")
+    {
+        std::stringstream ss;
+        REQUIRE(eph[1]->save(ss));
+        auto copy{Ephemeris::load(ss)};
+        REQUIRE(copy);
+        CHECK(copy->start() == eph[1]->start());
+        CHECK(copy->end() == eph[1]->end());
+        for (auto t : {0.0, 1e4, 2e5})
+        {
+            CHECK(copy->position(t) == eph[1]->position(t));
+            CHECK(copy->velocity(t) == eph[1]->velocity(t));
+        }
+
+        auto path{"test-ephemeris.bin"};
+        REQUIRE(eph[1]->save(path));
+        auto from_file{Ephemeris::load(path)};
+        std::remove(path);
+        REQUIRE(from_file);
+        CHECK(from_file->position(1e5) == eph[1]->position(1e5));
+
+        std::stringstream bad("not an ephemeris");
+        CHECK(!Ephemeris::load(bad));
+        // Headers that would divide by zero or allocate more than the stream holds.
+        auto header{[](std::uint64_t degree, std::uint64_t n) {
+            auto ss{std::make_shared<std::stringstream>()};
+            double const times[]{0.0, 1.0};
+            std::uint64_t const sizes[]{degree, n};
+            ss->write("LoftEphm", 8);
+            ss->write(reinterpret_cast<char const*>(times), sizeof(times));
+            ss->write(reinterpret_cast<char const*>(sizes), sizeof(sizes));
+            return ss;
+        }};
+        CHECK(!Ephemeris::load(*header(UINT64_MAX, 4)));
+        CHECK(!Ephemeris::load(*header(1, UINT64_MAX - 1)));
+        CHECK(!Ephemeris::load(*header(1, 1ull << 40)));
+        auto one{header(0, 1)};
+        one->write(std::string(sizeof(V3), '\0').data(), sizeof(V3));
+        CHECK(Ephemeris::load(*one));
+        CHECK(!Ephemeris::load("no-such-file.bin"));
+    }
+    SUBCASE("follow")
+    {
+        // A satellite in orbit around scripted worlds matches one in a fully integrated
+        // universe.
+        auto scripted{earth_and_moon()};
+        scripted.earth->follow(eph[0], 0.0);
+        scripted.moon->follow(eph[1], 0.0);
+        CHECK(scripted.moon->is_scripted());
+        CHECK(scripted.moon->ephemeris() == eph[1].get());
+        auto ref{earth_and_moon()};
+        auto v{std::sqrt(G*m_earth/(2*r_earth))};
+        auto sat{std::make_shared<Body>(1e3, M1, 2*r_earth*Vx, v*Vy, M1, V0)};
+        auto ref_sat{std::make_shared<Body>(1e3, M1, 2*r_earth*Vx, v*Vy, M1, V0)};
+        scripted.all->add(sat);
+        ref.all->add(ref_sat);
+        for (int i{0}; i < 1440; ++i)
+        {
+            scripted.all->step(60.0);
+            ref.all->step(60.0);
+        }
+        CHECK(close(scripted.moon->r_cm(), ref.moon->r_cm(), 1e3));
+        CHECK(close(sat->r_cm(), ref_sat->r_cm(), 1e3));
+
+        // Past the end, the worlds are integrated again.
+        for (int i{0}; i < 4*1440; ++i)
+            scripted.all->step(60.0);
+        CHECK(!scripted.moon->is_scripted());
+        CHECK(!scripted.moon->ephemeris());
+    }
+}
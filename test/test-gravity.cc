@@ -0,0 +1,93 @@
+#include "body.hh"
+#include "checkpoint.hh"
+#include "test.hh"
+#include "universe.hh"
+
+#include "doctest.h"
+
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+/// A body whose path is given in advance.
+struct Scripted_Body : public Body
+{
+    using Body::Body;
+    virtual bool is_scripted() const override
+    {
+        return true;
+    }
+};
+
+/// @return A cloud of bodies at rest with different masses, far from the origin.
+static std::shared_ptr<Universe> cloud(Universe::Precision precision)
+{
+    auto all{std::make_shared<Universe>(false)};
+    all->set_precision(precision);
+    V3 const center{4e8, -1e8, 2e7};
+    for (int i = 0; i < 40; ++i)
+    {
+        V3 r{1e3*std::sin(1.3*i), 1e3*std::cos(2.1*i), 1e3*std::sin(0.7*i + 0.2)};
+        all->add(std::make_shared<Body>(1e12*(1.0 + 0.1*i), M1, center + r, V0, M1, V0));
+    }
+    return all;
+}
+
+TEST_CASE("mixed precision gravity")
+{
+    auto full{cloud(Universe::Precision::full)};
+    auto mixed{cloud(Universe::Precision::mixed)};
+    CHECK(full->precision() == Universe::Precision::full);
+    CHECK(mixed->precision() == Universe::Precision::mixed);
+    full->set_diagnostics(true);
+    mixed->set_diagnostics(true);
+    full->step(1.0);
+    mixed->step(1.0);
+    // The potential energy is summed by the kernel.
+    CHECK(full->diagnostics().potential < 0.0);
+    CHECK(close(mixed->diagnostics().potential, full->diagnostics().potential,
+                1e-6*std::abs(full->diagnostics().potential)));
+    // The bodies started at rest, so the velocities are the changes from gravity.
+    for (auto it1{full->bodies().begin()}, it2{mixed->bodies().begin()};
+         it1 != full->bodies().end(); ++it1, ++it2)
+    {
+        auto v{(*it1)->v_cm()};
+        CHECK(mag(v) > 0.0);
+        CHECK(mag((*it2)->v_cm() - v) < 1e-5*mag(v));
+    }
+
+    SUBCASE("skipped pairs")
+    {
+        // Equal masses don't attract each other, nor do scripted bodies.
+        for (auto precision : {Universe::Precision::full, Universe::Precision::mixed})
+        {
+            Universe all(false);
+            all.set_precision(precision);
+            auto b1{std::make_shared<Body>(1e12, M1, V0, V0, M1, V0)};
+            auto b2{std::make_shared<Body>(1e12, M1, 10*Vx, V0, M1, V0)};
+            auto s1{std::make_shared<Scripted_Body>(2e12, M1, 10*Vy, V0, M1, V0)};
+            auto s2{std::make_shared<Scripted_Body>(3e12, M1, 10*Vz, V0, M1, V0)};
+            all.add(b1);
+            all.add(b2);
+            all.add(s1);
+            all.add(s2);
+            all.step(1.0);
+            // b1 is pulled only by the scripted bodies.
+            CHECK(b1->v_cm().x == 0.0);
+            CHECK(b1->v_cm().y > 0.0);
+            CHECK(b1->v_cm().z > 0.0);
+            // Each scripted body is pulled only by b1 and b2.
+            CHECK(s1->v_cm().z == 0.0);
+            CHECK(s2->v_cm().y == 0.0);
+        }
+    }
+    SUBCASE("checkpoint")
+    {
+        std::stringstream ss;
+        REQUIRE(Checkpoint::save(*mixed, ss));
+        auto copy{Checkpoint::load(ss)};
+        REQUIRE(copy);
+        CHECK(copy->precision() == Universe::Precision::mixed);
+    }
+}
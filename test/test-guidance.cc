@@ -0,0 +1,106 @@
+//  Copyright (C) 2022 Sam Varner
+//
+//  This file is part of Laft.
+//
+//  Loft is free software: you can redistribute it and/or modify it under the terms of
+//  the GNU General Public License as published by the Free Software Foundation, either
+//  version 3 of the License, or (at your option) any later version.
+//
+//  Vamos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with Vamos.
+//  If not, see <http://www.gnu.org/licenses/>.
+
+#include "guidance.hh"
+#include "launch.hh"
+#include "rocket.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <cmath>
+
+using namespace consts;
+
+TEST_CASE("guidance batch")
+{
+    // Each vehicle gets the same commands in a batch as it does alone.
+    Ascent ascent;
+    Guidance_Batch batch;
+    int const n{7};
+    batch.resize(n);
+    for (int i = 0; i < n; ++i)
+    {
+        auto r{r_earth + 5e3*i*i};
+        batch.rx[i] = r;
+        batch.ry[i] = 0.0;
+        batch.rz[i] = 0.0;
+        batch.vx[i] = 50.0 + 100.0*i;
+        batch.vy[i] = 400.0 + 1300.0*i;
+        batch.vz[i] = 0.0;
+        batch.wx[i] = 0.0;
+        batch.wy[i] = 400.0;
+        batch.wz[i] = 0.0;
+        batch.ex[i] = 0.0;
+        batch.ey[i] = 1.0;
+        batch.ez[i] = 0.0;
+        batch.mu[i] = G*m_earth;
+        batch.radius[i] = r_earth;
+        batch.accel[i] = 15.0;
+    }
+    guide(ascent, batch);
+    for (int i = 0; i < n; ++i)
+    {
+        Guidance_Batch one;
+        one.resize(1);
+        for (auto column : {&Guidance_Batch::rx, &Guidance_Batch::ry, &Guidance_Batch::rz,
+                            &Guidance_Batch::vx, &Guidance_Batch::vy, &Guidance_Batch::vz,
+                            &Guidance_Batch::wx, &Guidance_Batch::wy, &Guidance_Batch::wz,
+                            &Guidance_Batch::ex, &Guidance_Batch::ey, &Guidance_Batch::ez,
+                            &Guidance_Batch::mu, &Guidance_Batch::radius,
+                            &Guidance_Batch::accel})
+            (one.*column)[0] = (batch.*column)[i];
+        guide(ascent, one);
+        CHECK(one.dx[0] == batch.dx[i]);
+        CHECK(one.dy[0] == batch.dy[i]);
+        CHECK(one.dz[0] == batch.dz[i]);
+        CHECK(one.throttle[0] == batch.throttle[i]);
+        auto d{std::hypot(one.dx[0], one.dy[0], one.dz[0])};
+        CHECK(d == doctest::Approx(1.0));
+    }
+    // Vertical below the turn speed.
+    CHECK(batch.dx[0] == 1.0);
+    // Cut off at circular speed.
+    CHECK(batch.throttle[0] == 1.0);
+    CHECK(batch.throttle[n-1] == 0.0);
+}
+
+TEST_CASE("guidance to orbit")
+{
+    // Fly the launch with guidance instead of the scripted pitch-over.
+    Launch launch;
+    launch.turn_time = 1e9;
+    launch.straight_time = 1e9;
+    auto member{launch.build()};
+    auto rocket{std::dynamic_pointer_cast<Rocket>(member.probe)};
+    Ascent ascent;
+    Guidance guidance(ascent);
+    guidance.add(rocket, member.world);
+    double const dt{0.1};
+    while (!guidance.done(0) && member.universe->time() < 2000.0)
+    {
+        guidance.observe(*member.universe);
+        member.universe->step(dt);
+    }
+    REQUIRE(guidance.done(0));
+    auto r{rocket->r_cm() - member.world->r_cm()};
+    auto v{rocket->v_cm() - member.world->v_cm()};
+    auto R{r_earth + ascent.altitude};
+    CHECK(mag(r) == doctest::Approx(R).epsilon(0.01));
+    CHECK(std::abs(dot(v, unit(r))) < 10.0);
+    CHECK(mag(v) == doctest::Approx(std::sqrt(G*m_earth/R)).epsilon(0.01));
+    CHECK(rocket->fuel_volume() > 0.0);
+}
@@ -0,0 +1,137 @@
+#include "harmonics.hh"
+#include "test.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <cmath>
+#include <memory>
+#include <numbers>
+
+using namespace consts;
+using namespace std::numbers;
+
+TEST_CASE("harmonics")
+{
+    double const R{6.4e6};
+    double const mu{G*m_earth};
+    double const J2{1.0826e-3};
+    Harmonics::Workspace work;
+    V3 const r{5e6, -3e6, 4e6};
+    auto r2{dot(r, r)};
+    auto r5{r2*r2*std::sqrt(r2)};
+
+    SUBCASE("J2")
+    {
+        Harmonics field(R, {{2, 0, -J2/std::sqrt(5.0), 0.0}});
+        CHECK(field.degree() == 2);
+        CHECK(field.radius() == R);
+        auto k{-1.5*J2*mu*R*R/r5};
+        auto z2{r.z*r.z/r2};
+        V3 expected{k*r.x*(1 - 5*z2), k*r.y*(1 - 5*z2), k*r.z*(3 - 5*z2)};
+        CHECK(close(field.acceleration(r, mu, 2, 0, work), expected, 1e-12));
+        // Higher requests are clamped.
+        CHECK(close(field.acceleration(r, mu, 8, 8, work), expected, 1e-12));
+        // Below degree 2 there's nothing to add to the point mass.
+        CHECK(field.acceleration(r, mu, 1, 1, work) == V0);
+        CHECK(field.acceleration(V0, mu, 2, 0, work) == V0);
+    }
+    SUBCASE("sectoral")
+    {
+        double const C{2.4e-6};
+        double const S{-1.4e-6};
+        Harmonics field(R, {{2, 2, C, S}});
+        // Unnormalized, the potential is 3μR²/r⁵(C(x² - y²) + 2Sxy).
+        auto norm{std::sqrt(10.0/24.0)};
+        auto c{norm*C};
+        auto s{norm*S};
+        auto U{3*mu*R*R/r5*(c*(r.x*r.x - r.y*r.y) + 2*s*r.x*r.y)};
+        auto k{3*mu*R*R/r5};
+        V3 expected{k*(2*c*r.x + 2*s*r.y) - 5*U*r.x/r2,
+                    k*(-2*c*r.y + 2*s*r.x) - 5*U*r.y/r2,
+                    -5*U*r.z/r2};
+        CHECK(close(field.acceleration(r, mu, 2, 2, work), expected, 1e-12));
+        // Leaving out the order leaves out the term.
+        CHECK(field.acceleration(r, mu, 2, 1, work) == V0);
+    }
+    SUBCASE("earth")
+    {
+        auto earth{Harmonics::earth()};
+        CHECK(earth == Harmonics::earth());
+        CHECK(earth->degree() == 4);
+        // Gradients of the potential summed directly with Legendre functions.
+        V3 const zonal{4.46868091e-3, -2.68120854e-3, -8.34153769e-3};
+        V3 const full{4.47605136e-3, -2.55390800e-3, -8.34317763e-3};
+        CHECK(close(earth->acceleration(r, mu, 2, 0, work), zonal, 1e-11));
+        CHECK(close(earth->acceleration(r, mu, 4, 4, work), full, 1e-11));
+    }
+}
+
+TEST_CASE("world harmonics")
+{
+    auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, rot(M1, 0.4*Vy),
+                                       units::day(1.0))};
+    CHECK(!earth->harmonics());
+    CHECK(earth->perturbation(2*r_earth*Vx) == V0);
+    earth->set_harmonics(Harmonics::earth(), 9, 3);
+    CHECK(earth->harmonics() == Harmonics::earth().get());
+    CHECK(earth->harmonics_degree() == 4);
+    CHECK(earth->harmonics_order() == 3);
+
+    // The field turns with the world.  Check against the field's own frame with x at
+    // zero longitude.
+    double const lat{0.3};
+    double const lon{-1.2};
+    double const alt{4e5};
+    auto [r, m] = earth->locate(lat, lon, alt);
+    auto a{earth->perturbation(r)};
+    auto d{r_earth + alt};
+    V3 r_field{d*std::cos(lat)*std::cos(lon), d*std::cos(lat)*std::sin(lon),
+               d*std::sin(lat)};
+    Harmonics::Workspace work;
+    auto a_field{Harmonics::earth()->acceleration(r_field, G*m_earth, 4, 3, work)};
+    V3 east{-std::sin(lon), std::cos(lon), 0.0};
+    V3 north{-std::sin(lat)*std::cos(lon), -std::sin(lat)*std::sin(lon), std::cos(lat)};
+    CHECK(dot(a, m*Vx) == doctest::Approx(dot(a_field, east)));
+    CHECK(dot(a, m*Vy) == doctest::Approx(dot(a_field, north)));
+    CHECK(dot(a, m*Vz) == doctest::Approx(dot(a_field, unit(r_field))));
+
+    earth->set_harmonics(nullptr, 4, 4);
+    CHECK(earth->harmonics_degree() == 0);
+    CHECK(earth->perturbation(r) == V0);
+}
+
+TEST_CASE("nodal regression")
+{
+    // J2 turns the plane of an inclined orbit westward.
+    auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, M1, units::day(1.0))};
+    earth->set_harmonics(Harmonics::earth(), 2, 0);
+    double const a{r_earth + 5e5};
+    double const mu{G*m_earth};
+    double const incl{pi/4};
+    auto v{std::sqrt(mu/a)};
+    auto sat{std::make_shared<Body>(1e3, M1, a*Vx,
+                                    v*V3(0.0, std::cos(incl), std::sin(incl)), M1, V0)};
+    Universe all(false);
+    all.add(earth);
+    all.add(sat);
+    auto p0{earth->m()*earth->v_cm() + sat->m()*sat->v_cm()};
+
+    auto n{std::sqrt(mu/(a*a*a))};
+    auto R{Harmonics::earth()->radius()};
+    auto rate{-1.5*n*1.08263e-3*R*R/(a*a)*std::cos(incl)};
+    double const time{2*pi/n};
+    for (int i{0}; i < 5000; ++i)
+        all.step(time/5000);
+    auto h{cross(sat->r() - earth->r(), sat->v_cm() - earth->v_cm())};
+    // The ascending node is in the direction of z × h.
+    auto node{cross(Vz, h)};
+    auto angle{std::atan2(node.y, node.x)};
+    CHECK(angle == doctest::Approx(rate*time).epsilon(0.05));
+
+    // The world takes the opposite impulses.
+    auto p1{earth->m()*earth->v_cm() + sat->m()*sat->v_cm()};
+    CHECK(close(p1, p0, 1e-3));
+}
@@ -1,10 +1,14 @@
 #include <rocket.hh>
 #include <units.hh>
+#include <universe.hh>
+#include <world.hh>
 
 #include "test.hh"
 
 #include "doctest.h"
 
+#include <cmath>
+#include <memory>
 #include <numbers>
 
 using namespace std::numbers;
@@ -113,3 +117,121 @@ TEST_CASE("thrust")
     CHECK(close(rocket.omega().y, 0.0, 1e-9));
     CHECK(rocket.omega().z > 1e-3);
 }
+
+TEST_CASE("rocket equation")
+{
+    double m_s = 10;
+    double m_e = 50;
+    double r = 0.5;
+    double l = 10;
+    double rho = 1.5;
+    double impulse = 1e3;
+    double rate = 0.01;
+    auto o = rot(M1, pi/2*Vy);
+    auto burn = [&](int steps, double time) {
+        auto rocket{std::make_shared<Rocket>(m_s, m_e, r, l, rho, impulse, rate, V0, o)};
+        rocket->throttle(1.0);
+        for (int i = 0; i < steps; ++i)
+            rocket->step(time/steps);
+        return rocket;
+    };
+
+    // Half the fuel.
+    double V = units::V_cylinder(r, l);
+    double m0 = m_s + m_e + rho*V;
+    double m1 = m0 - rho*V/2;
+    auto one{burn(1, V/2/rate)};
+    auto many{burn(100, V/2/rate)};
+    CHECK(close(one->v_cm(), impulse*std::log(m0/m1)*Vx, 1e-9));
+    CHECK(close(many->v_cm(), one->v_cm(), 1e-9));
+    // Thrust acts throughout the step, so the distance doesn't depend on the step size
+    // either.  With the mass falling linearly, the distance after time t is
+    // vₑ (t - m(t)/ṁ ln(m₀/m(t))).
+    double m_dot = rho*rate;
+    double t1 = V/2/rate;
+    auto x1{impulse*(t1 - m1/m_dot*std::log(m0/m1))};
+    CHECK(close(one->transform_out(V0), x1*Vx, 1e-9));
+    CHECK(close(many->transform_out(V0), x1*Vx, 1e-9));
+
+    // The tank runs dry part way through the step.
+    double m2 = m_s + m_e;
+    auto dry{burn(1, 2*V/rate)};
+    CHECK(close(dry->v_cm(), impulse*std::log(m0/m2)*Vx, 1e-9));
+    CHECK(dry->m() == m2);
+    // Coasting after the burn.
+    double t2 = V/rate;
+    auto x2{impulse*(t2 - m2/m_dot*std::log(m0/m2)) + dry->v_cm().x*t2};
+    CHECK(close(dry->transform_out(V0), x2*Vx, 1e-9));
+}
+
+TEST_CASE("burn under gravity")
+{
+    // Thrust and gravity both act throughout the step, so large steps stay close to
+    // small ones.
+    auto climb = [](double dt) {
+        Universe all(false);
+        auto earth{std::make_shared<World>(consts::m_earth, consts::r_earth, V0, V0, M1,
+                                           units::day(1.0))};
+        auto r{(consts::r_earth + 1e5)*Vx};
+        auto rocket{std::make_shared<Rocket>(10, 50, 0.5, 10, 1.2, 8e4, 0.01, r,
+                                             rot(M1, pi/2*Vy))};
+        all.add(earth);
+        all.add(rocket);
+        rocket->throttle(1.0);
+        for (int i = 0; i < static_cast<int>(std::round(100.0/dt)); ++i)
+            all.step(dt);
+        return std::make_pair(rocket->r_cm() - earth->r_cm(), rocket->v_cm());
+    };
+    auto [r_small, v_small] = climb(0.1);
+    auto [r_large, v_large] = climb(10.0);
+    // About 120 km up at about 440 m/s.
+    CHECK(mag(r_small) - consts::r_earth > 1e5);
+    CHECK(close(r_large, r_small, 1.0));
+    CHECK(close(v_large, v_small, 0.05));
+}
+
+TEST_CASE("stages")
+{
+    double m_s = 10;
+    double m_e = 50;
+    double r = 0.5;
+    double l = 10;
+    double rho = 1.5;
+    double impulse = 1e3;
+    double rate = 0.01;
+    auto o = rot(M1, pi/2*Vy);
+    // Rocket is oriented along +x with the lower stage behind it.
+    auto rocket{std::make_shared<Rocket>(m_s, m_e, r, l, rho, impulse, rate, V0, o)};
+    auto lower{std::make_shared<Rocket>(2*m_s, 2*m_e, r, l, rho, impulse, 2*rate,
+                                        -l*Vx, o)};
+    auto m_upper{rocket->m()};
+    auto m_lower{lower->m()};
+    auto cm{(m_upper*rocket->r_cm() + m_lower*lower->r_cm())/(m_upper + m_lower)};
+    rocket->add_stage(lower);
+    CHECK(rocket->stages() == 1);
+    CHECK(!lower->is_free());
+    CHECK(rocket->m() == m_upper + m_lower);
+    CHECK(close(rocket->r_cm(), cm, 1e-12));
+
+    // The lower stage burns its fuel.
+    double V = units::V_cylinder(r, l);
+    rocket->throttle(1.0);
+    CHECK(rocket->max_thrust() == 2*rate*rho*impulse);
+    rocket->step(1.0);
+    CHECK(close(lower->fuel_volume(), V - 2*rate, 1e-12));
+    CHECK(rocket->fuel_volume() == lower->fuel_volume());
+    CHECK(close(rocket->m(), m_upper + m_lower - 2*rate*rho, 1e-12));
+    CHECK(rocket->v_cm().x > 0.0);
+
+    // Jettison.  Momentum is conserved and the upper engine takes over.
+    auto p{rocket->m()*rocket->v_cm()};
+    CHECK(rocket->stage() == lower);
+    CHECK(rocket->stages() == 0);
+    CHECK(lower->is_free());
+    CHECK(rocket->m() == m_upper);
+    CHECK(close(rocket->m()*rocket->v_cm() + lower->m()*lower->v_cm(), p, 1e-9));
+    CHECK(lower->thrust() == V0);
+    CHECK(rocket->fuel_volume() == V);
+    CHECK(close(rocket->thrust(), rate*rho*impulse*Vx, 1e-9));
+    CHECK(!rocket->stage());
+}
@@ -0,0 +1,114 @@
+#include "body.hh"
+#include "runner.hh"
+#include "test.hh"
+#include "triple-buffer.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <thread>
+
+using namespace consts;
+
+/// A small orbit for stepping.
+struct Orbit
+{
+    Orbit()
+        : earth{std::make_shared<World>(m_earth, r_earth, V0, V0, M1, units::day(1))},
+          sat{std::make_shared<Body>(1e3, M1, 2*r_earth*Vx, 5e3*Vy, M1, V0)},
+          all{false}
+    {
+        all.add(earth);
+        all.add(sat);
+    }
+    std::shared_ptr<World> earth;
+    std::shared_ptr<Body> sat;
+    Universe all;
+};
+
+TEST_CASE("fixed step")
+{
+    Orbit o1;
+    Runner r1(o1.all, 0.5);
+    CHECK(r1.run(100.0) == 200);
+    CHECK(o1.all.time() == 100.0);
+
+    // Uneven frames give the same steps.
+    Orbit o2;
+    Runner r2(o2.all, 0.5);
+    std::size_t n{0};
+    for (auto frame : {0.3, 0.3, 1.7, 0.05, 97.65})
+        n += r2.advance(frame);
+    CHECK(n == 200);
+    CHECK(o2.all.time() == o1.all.time());
+    CHECK(o2.sat->r() == o1.sat->r());
+    CHECK(o2.sat->v_cm() == o1.sat->v_cm());
+
+    // Leftover time is carried to the next call.
+    CHECK(r2.advance(0.4) == 0);
+    CHECK(r2.advance(0.1) == 1);
+}
+
+TEST_CASE("observe and stop")
+{
+    Orbit o;
+    Runner runner(o.all, 1.0);
+    std::size_t calls{0};
+    runner.observe([&](Universe& u) {
+        ++calls;
+        if (u.time() >= 10.0)
+            runner.stop();
+    });
+    CHECK(runner.run(100.0) == 10);
+    CHECK(calls == 10);
+    // Stopping doesn't carry over to the next run.
+    CHECK(runner.run(5.0) == 1);
+}
+
+TEST_CASE("pacing")
+{
+    Orbit o;
+    Runner runner(o.all, 0.01);
+    runner.set_pacing(2.0);
+    auto start{std::chrono::steady_clock::now()};
+    runner.run(0.1);
+    std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+    CHECK(elapsed.count() >= 0.05);
+}
+
+TEST_CASE("triple buffer")
+{
+    Triple_Buffer<std::array<int, 64>> buffer;
+    CHECK(!buffer.update());
+
+    // Every element of a value is written before it's published, so the consumer never
+    // sees a mix of two values, and values never go backwards.
+    constexpr int last{20000};
+    std::thread producer([&buffer]() {
+        for (int i = 1; i <= last; ++i)
+        {
+            buffer.back().fill(i);
+            buffer.publish();
+        }
+    });
+    int seen{0};
+    bool torn{false};
+    while (seen < last)
+    {
+        if (!buffer.update())
+            continue;
+        auto const& value{buffer.front()};
+        torn |= std::any_of(value.begin(), value.end(),
+                            [&value](int x) { return x != value[0]; });
+        CHECK(value[0] > seen);
+        seen = value[0];
+    }
+    producer.join();
+    CHECK(!torn);
+    CHECK(!buffer.update());
+}
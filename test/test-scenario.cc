@@ -0,0 +1,142 @@
+#include "launch.hh"
+#include "rocket.hh"
+#include "runner.hh"
+#include "scenario.hh"
+#include "test.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <sstream>
+
+// The default launch.  The same as scenarios/launch.loft.
+static std::string const launch{R"(
+universe collisions=1
+world earth mass=5.972e24 radius=6.361e6 period=1day orientation=0,23.44deg,0
+rocket rocket shell_mass=10 engine_mass=50 radius=0.5 length=10 fuel_density=1.2 )"
+R"(specific_impulse=8e4 fuel_rate=0.01 throttle=1 on=earth lat=28:31:27 lon=-80:39:3 alt=1
+at 1 release earth rocket   # lift off
+at 110 orient rocket 0,-2e-5,0
+at 142 orient rocket 0,0,0
+)"};
+
+TEST_CASE("scenario")
+{
+    SUBCASE("launch")
+    {
+        // The scenario flies the same as Launch.
+        std::string error;
+        auto scenario{Scenario::parse(launch, &error)};
+        REQUIRE_MESSAGE(scenario, error);
+        auto rocket{scenario->get<Rocket>("rocket")};
+        REQUIRE(rocket);
+        CHECK(scenario->get<World>("earth"));
+        CHECK(!scenario->get<World>("rocket"));
+        CHECK(!scenario->body("moon"));
+        CHECK(!rocket->is_free());
+        CHECK(scenario->universe()->scheduled() == 3);
+
+        auto member{Launch().build()};
+        Runner r1(*scenario->universe(), 0.5);
+        Runner r2(*member.universe, 0.5);
+        r1.run(200.0);
+        r2.run(200.0);
+        CHECK(rocket->is_free());
+        CHECK(rocket->r() == member.probe->r());
+        CHECK(rocket->v_cm() == member.probe->v_cm());
+        CHECK(rocket->fuel_volume()
+              == std::dynamic_pointer_cast<Rocket>(member.probe)->fuel_volume());
+    }
+    SUBCASE("bodies")
+    {
+        auto scenario{Scenario::parse(R"(
+universe collisions=0
+body a mass=2 inertia=1,2,3 r=1,0,0 v=0,1,0 orientation=0,0,90deg omega=0,0,1
+body b mass=1
+body - mass=1
+capture a b
+)")};
+        REQUIRE(scenario);
+        CHECK(scenario->universe()->bodies().size() == 3);
+        auto a{scenario->body("a")};
+        CHECK(a->m() == 3.0);
+        CHECK(a->v_cm() == Vy*2.0/3.0);
+        CHECK(close(a->rotate_out(Vx), Vy, 1e-12));
+        CHECK(!scenario->body("b")->is_free());
+    }
+    SUBCASE("world without a period")
+    {
+        auto scenario{Scenario::parse("world moon mass=7e22 radius=1.7e6 v=1,0,0")};
+        REQUIRE(scenario);
+        auto moon{scenario->body("moon")};
+        CHECK(moon->omega() == V0);
+        scenario->universe()->step(1.0);
+        CHECK(moon->r_cm() == Vx);
+        CHECK(moon->omega() == V0);
+    }
+    SUBCASE("stages")
+    {
+        auto scenario{Scenario::parse(R"(
+rocket upper shell_mass=10 engine_mass=50 radius=0.5 length=10 fuel_density=1 throttle=1
+rocket lower shell_mass=20 engine_mass=90 radius=0.5 length=10 fuel_density=1 r=0,0,-10
+stage upper lower
+at 5 stage upper
+)")};
+        REQUIRE(scenario);
+        auto upper{scenario->get<Rocket>("upper")};
+        auto lower{scenario->get<Rocket>("lower")};
+        CHECK(upper->stages() == 1);
+        CHECK(!lower->is_free());
+        scenario->universe()->step(10.0);
+        CHECK(upper->stages() == 0);
+        CHECK(lower->is_free());
+    }
+    SUBCASE("many bodies")
+    {
+        int const n{10000};
+        std::ostringstream os;
+        for (int i = 0; i < n; ++i)
+            os << "body - mass=1e3 r=" << i << ",0,0 v=0," << 0.5*i << ",0\n";
+        auto scenario{Scenario::parse(os.str())};
+        REQUIRE(scenario);
+        CHECK(scenario->universe()->bodies().size() == n);
+        CHECK(scenario->universe()->bodies().back()->v_cm() == V3(0, 0.5*(n - 1), 0));
+    }
+    SUBCASE("errors")
+    {
+        std::string error;
+        CHECK(!Scenario::parse("body a mass=1\nbody a mass=1", &error));
+        CHECK(error == "line 2: duplicate name: a");
+        CHECK(!Scenario::parse("\n\n# comment\nbody a mass=x", &error));
+        CHECK(error == "line 4: bad argument: mass=x");
+        CHECK(!Scenario::parse("body a color=red", &error));
+        CHECK(!Scenario::parse("planet a", &error));
+        CHECK(error == "line 1: unknown command: planet");
+        CHECK(!Scenario::parse("body a\nat 1 throttle a 1", &error));
+        CHECK(error == "line 2: throttle needs a rocket");
+        CHECK(!Scenario::parse("body a on=b", &error));
+        CHECK(!Scenario::parse("capture a b", &error));
+        CHECK(!Scenario::parse("body a\ncapture a a", &error));
+        CHECK(error == "line 2: can't capture itself");
+        CHECK(!Scenario::parse("body a\nbody b\ncapture a b\ncapture b a", &error));
+        CHECK(error == "line 4: can't capture a parent");
+        CHECK(!Scenario::parse("body a\nbody b\nbody c\ncapture a c\ncapture b c",
+                               &error));
+        CHECK(error == "line 5: already captured");
+        CHECK(!Scenario::parse("world w radius=1\nbody a on=w\nbody b\ncapture b a",
+                               &error));
+        CHECK(error == "line 4: already captured");
+        CHECK(!Scenario::parse("body a\nbody b\nat 1 release a b", &error));
+        CHECK(error == "line 3: not captured");
+        // Events are checked in time order.
+        CHECK(Scenario::parse("body a\nbody b\nat 2 release a b\nat 1 capture a b"));
+        CHECK(!Scenario::parse("body a\nbody b\ncapture a b\nat 2 capture b a\n"
+                               "at 1 release a b\nat 3 capture a b", &error));
+        CHECK(error == "line 6: can't capture a parent");
+        CHECK(!Scenario::parse("body a lat=1:2", &error));
+        CHECK(!Scenario::parse("universe collisions=1 extra", &error));
+        CHECK(!Scenario::load("no-such-scenario.loft", &error));
+        CHECK(error == "can't read no-such-scenario.loft");
+    }
+}
@@ -0,0 +1,158 @@
+#include "launch.hh"
+#include "rocket.hh"
+#include "script.hh"
+#include "test.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+static Script record_times(Universe& u, std::vector<double>& times)
+{
+    times.push_back(u.time());
+    co_await after(0.25);
+    times.push_back(u.time());
+    co_await after(0.0);
+    times.push_back(u.time());
+    co_await until([&u] { return u.time() > 2.0; });
+    times.push_back(u.time());
+    co_await after(10.0);
+    times.push_back(u.time());
+}
+
+/// Counts the scripts that have local objects in existence.
+static int alive{0};
+
+struct Local
+{
+    Local() { ++alive; }
+    ~Local() { --alive; }
+};
+
+static Script wait_forever(Universe&)
+{
+    Local local;
+    co_await until([] { return false; });
+}
+
+static Script fail(Universe&)
+{
+    Local local;
+    co_await after(1.0);
+    throw std::runtime_error("fail");
+}
+
+static Script ascent(Universe& u, std::shared_ptr<World> earth,
+                     std::shared_ptr<Rocket> rocket, double& crossed)
+{
+    auto high{[=] {
+        auto [lat, lon, alt] = earth->location(rocket->r_cm());
+        return alt > 1e4;
+    }};
+    co_await until(high);
+    crossed = u.time();
+    rocket->orient_thrust(-2e-5*Vy);
+}
+
+static Script hold(Universe& u, std::shared_ptr<int> held)
+{
+    auto later{[held, &u] { return u.time() > 1.0; }};
+    co_await until(later);
+}
+
+/// True if until() accepts the condition.
+template <typename F>
+concept Condition = requires(F&& condition) { until(std::forward<F>(condition)); };
+
+// Temporaries with destructors are rejected.
+static_assert(Condition<bool (*)()>);
+static_assert(Condition<std::function<bool()>&>);
+static_assert(!Condition<std::function<bool()>>);
+
+TEST_CASE("script")
+{
+    Universe all(false);
+    SUBCASE("wait")
+    {
+        std::vector<double> times;
+        auto script{record_times(all, times)};
+        // Scripts start with the next step.
+        CHECK(times.empty());
+        all.step(1.0);
+        CHECK(times == std::vector<double>{0.0, 0.25, 0.25});
+        CHECK(all.watched() == 1);
+        all.step(1.0);
+        all.step(1.0);
+        CHECK(times.back() == 3.0);
+        CHECK(!script.done());
+        all.step(100.0);
+        CHECK(times == std::vector<double>{0.0, 0.25, 0.25, 3.0, 13.0});
+        CHECK(script.done());
+        CHECK(all.scheduled() == 0);
+        CHECK(all.watched() == 0);
+    }
+    SUBCASE("many")
+    {
+        std::vector<double> times;
+        for (int i = 0; i < 1000; ++i)
+            record_times(all, times);
+        for (int i = 0; i < 5; ++i)
+            all.step(10.0);
+        CHECK(times.size() == 5000);
+    }
+    SUBCASE("exception")
+    {
+        auto script{fail(all)};
+        all.step(0.5);
+        CHECK(alive == 1);
+        CHECK_THROWS_AS(all.step(1.0), std::runtime_error);
+        CHECK(script.done());
+        CHECK(alive == 0);
+    }
+    SUBCASE("destroy")
+    {
+        // Waiting scripts are destroyed with the universe.
+        {
+            Universe u(false);
+            wait_forever(u);
+            u.step(1.0);
+            CHECK(alive == 1);
+            // Never started.
+            wait_forever(u);
+        }
+        CHECK(alive == 0);
+    }
+    SUBCASE("captures")
+    {
+        // The condition's copy of the pointer is released exactly once.
+        auto held{std::make_shared<int>(1)};
+        std::weak_ptr<int> weak{held};
+        auto script{hold(all, held)};
+        all.step(1.0);
+        CHECK(held.use_count() > 1);
+        all.step(1.0);
+        CHECK(script.done());
+        CHECK(weak.use_count() == 1);
+        held.reset();
+        CHECK(weak.expired());
+    }
+    SUBCASE("launch")
+    {
+        auto member{Launch().build()};
+        auto earth{member.world};
+        auto rocket{std::dynamic_pointer_cast<Rocket>(member.probe)};
+        double crossed{0.0};
+        auto script{ascent(*member.universe, earth, rocket, crossed)};
+        for (int i = 0; i < 100 && !script.done(); ++i)
+            member.universe->step(1.0);
+        CHECK(script.done());
+        CHECK(crossed > 1.0);
+        CHECK(member.universe->watched() == 0);
+    }
+}
@@ -0,0 +1,176 @@
+#include "launch.hh"
+#include "ring-buffer.hh"
+#include "rocket.hh"
+#include "runner.hh"
+#include "telemetry.hh"
+#include "test.hh"
+#include "universe.hh"
+
+#include "doctest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <thread>
+
+TEST_CASE("ring buffer")
+{
+    Ring_Buffer<int> ring(5);
+    CHECK(ring.capacity() == 8);
+    int value;
+    CHECK(!ring.pop(value));
+    for (int i = 0; i < 8; ++i)
+        CHECK(ring.push(i));
+    CHECK(!ring.push(8));
+    CHECK(ring.pop(value));
+    CHECK(value == 0);
+    CHECK(ring.push(8));
+
+    SUBCASE("threads")
+    {
+        // Values arrive in order when the consumer runs on another thread.
+        Ring_Buffer<int> ring2(16);
+        int const n{10000};
+        std::jthread producer([&] {
+            for (int i = 0; i < n; ++i)
+                while (!ring2.push(i))
+                    std::this_thread::yield();
+        });
+        int next{0};
+        bool in_order{true};
+        while (next < n)
+        {
+            if (ring2.pop(value))
+                in_order = in_order && value == next++;
+            else
+                std::this_thread::yield();
+        }
+        CHECK(in_order);
+    }
+}
+
+TEST_CASE("rocket thrust")
+{
+    Rocket rocket(10, 50, 0.5, 10, 1.2, 8.0e4, 0.01, V0, M1);
+    CHECK(rocket.thrust() == V0);
+    rocket.throttle(0.5);
+    // impulse * density * throttle * fuel rate along the rocket's axis
+    CHECK(close(rocket.thrust(), 8.0e4*1.2*0.5*0.01*Vz, 1e-9));
+}
+
+TEST_CASE("telemetry")
+{
+    auto member{Launch().build()};
+    Runner runner(*member.universe, 0.1);
+
+    SUBCASE("csv")
+    {
+        auto path{"test-telemetry.csv"};
+        {
+            Telemetry telemetry(path);
+            REQUIRE(telemetry.is_open());
+            CHECK(telemetry.channel("x") == 0);
+            CHECK(telemetry.channel("x") == 0);
+            Body_Telemetry rocket(telemetry, "rocket", member.probe, member.world);
+            runner.observe([&](Universe& all) { rocket.observe(all); });
+            runner.run(2.0);
+            CHECK(telemetry.dropped() == 0);
+        }
+        std::ifstream is(path);
+        std::string line;
+        std::getline(is, line);
+        CHECK(line == "time,channel,value");
+        std::map<std::string, int> counts;
+        std::string last_alt;
+        while (std::getline(is, line))
+        {
+            auto c1{line.find(',')};
+            auto c2{line.find(',', c1 + 1)};
+            auto name{line.substr(c1 + 1, c2 - c1 - 1)};
+            ++counts[name];
+            if (name == "rocket.alt")
+                last_alt = line.substr(c2 + 1);
+        }
+        CHECK(counts.size() == 8);
+        CHECK(counts["rocket.fuel"] == 20);
+        CHECK(counts["rocket.thrust.z"] == 20);
+        // Still on the pad.
+        CHECK(std::abs(std::stod(last_alt)) < 2.0);
+        std::remove(path);
+    }
+    SUBCASE("binary")
+    {
+        auto path{"test-telemetry.bin"};
+        {
+            Telemetry telemetry(path, Telemetry::Format::binary);
+            Body_Telemetry rocket(telemetry, "rocket", member.probe);
+            runner.observe([&](Universe& all) { rocket.observe(all); });
+            runner.run(1.0);
+        }
+        std::ifstream is(path, std::ios::binary);
+        std::string data(std::istreambuf_iterator<char>(is), {});
+        REQUIRE(data.substr(0, 8) == "LoftTlm1");
+        std::size_t pos{8};
+        std::vector<std::string> names;
+        std::vector<int> counts;
+        auto get32{[&] {
+            std::uint32_t x;
+            std::memcpy(&x, data.data() + pos, 4);
+            pos += 4;
+            return x;
+        }};
+        while (pos < data.size())
+        {
+            auto kind{get32()};
+            auto channel{get32()};
+            if (kind == 1)
+            {
+                CHECK(channel == names.size());
+                auto length{get32()};
+                names.push_back(data.substr(pos, length));
+                counts.push_back(0);
+                pos += length;
+            }
+            else
+            {
+                REQUIRE(channel < names.size());
+                ++counts[channel];
+                pos += 16;
+            }
+        }
+        CHECK(pos == data.size());
+        CHECK(names == std::vector<std::string>{"rocket.speed", "rocket.fuel",
+                                                "rocket.thrust.x", "rocket.thrust.y",
+                                                "rocket.thrust.z"});
+        CHECK(counts == std::vector<int>(5, 10));
+        std::remove(path);
+    }
+    SUBCASE("channels")
+    {
+        auto path{"test-telemetry-channels.csv"};
+        {
+            Telemetry telemetry(path);
+            CHECK(telemetry.vector_channel("a") == 0);
+            CHECK(telemetry.vector_channel("a") == 0);
+            CHECK(telemetry.channels({"b", "c"}) == 3);
+            // Components registered separately can't be made consecutive.
+            CHECK(telemetry.channel("v.y") == 5);
+            CHECK(telemetry.channel("w") == 6);
+            CHECK(telemetry.vector_channel("v") == -1);
+            CHECK(telemetry.channels({"c", "b"}) == -1);
+            CHECK(telemetry.channels({}) == -1);
+            telemetry.publish(-1, 1.0, V3(1.0, 2.0, 3.0));
+            telemetry.publish(-1, 1.0, 4.0);
+            // Unregistered channels are skipped by the writer.
+            telemetry.publish(99, 1.0, 5.0);
+            telemetry.publish(6, 2.0, 6.0);
+        }
+        std::ifstream is(path);
+        std::string data(std::istreambuf_iterator<char>(is), {});
+        CHECK(data == "time,channel,value\n2,w,6\n");
+        std::remove(path);
+    }
+}
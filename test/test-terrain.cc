@@ -0,0 +1,155 @@
+#include "body.hh"
+#include "checkpoint.hh"
+#include "terrain.hh"
+#include "test.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <numbers>
+#include <sstream>
+
+using namespace consts;
+using namespace std::numbers;
+
+/// A surface that's easy to check: 500 m at the north pole on the 180° meridian, 1500 m
+/// at the north pole on the prime meridian.
+static double hills(double lat, double lon)
+{
+    return 1000.0 + 500.0*std::sin(lat)*std::cos(lon);
+}
+
+TEST_CASE("terrain")
+{
+    auto path{"test-terrain.bin"};
+    // 90° tiles with 11.25° between samples.
+    REQUIRE(Terrain::write(path, 2, 4, 9, hills));
+    auto const step{units::deg(11.25)};
+
+    SUBCASE("missing")
+    {
+        Terrain terrain("no-such-terrain.bin");
+        CHECK(!terrain.is_open());
+        CHECK(terrain.height(0.0, 0.0) == 0.0);
+    }
+    SUBCASE("oversized")
+    {
+        // 2¹⁶ × 2¹⁶ tiles is zero in 32 bits.
+        std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+        std::uint32_t const dimensions[]{1 << 16, 1 << 16};
+        fs.seekp(16);
+        fs.write(reinterpret_cast<char const*>(dimensions), sizeof(dimensions));
+        fs.close();
+        CHECK(!Terrain(path).is_open());
+    }
+    SUBCASE("heights")
+    {
+        Terrain terrain(path);
+        REQUIRE(terrain.is_open());
+        CHECK(terrain.path() == path);
+        CHECK(terrain.min_height() == 500.0);
+        CHECK(terrain.max_height() == 1500.0);
+        for (int i = 0; i <= 16; ++i)
+            for (int j = 0; j <= 32; ++j)
+            {
+                auto lat{-pi/2 + i*step};
+                auto lon{-pi + j*step};
+                CHECK(close(terrain.height(lat, lon), std::round(hills(lat, lon)), 1e-9));
+            }
+        // Between samples.
+        auto h{terrain.height(0.5*step, 0.25*step)};
+        CHECK(h > terrain.height(0.0, 0.0));
+        CHECK(h < terrain.height(step, 0.0));
+        // Longitude wraps and latitude is clamped.
+        CHECK(close(terrain.height(0.3, 0.4 + 2*pi), terrain.height(0.3, 0.4), 1e-9));
+        CHECK(close(terrain.height(0.3, 0.4 - 4*pi), terrain.height(0.3, 0.4), 1e-9));
+        CHECK(terrain.height(pi, 0.0) == terrain.height(pi/2, 0.0));
+    }
+    SUBCASE("cache")
+    {
+        Terrain terrain(path, 2);
+        CHECK(terrain.mapped_tiles() == 0);
+        auto h{terrain.height(0.1, 0.1)};
+        terrain.height(0.1, -0.1);
+        CHECK(terrain.mapped_tiles() == 2);
+        terrain.height(-0.1, 0.1);
+        CHECK(terrain.mapped_tiles() == 2);
+        // Evicted tiles are mapped again.
+        CHECK(terrain.height(0.1, 0.1) == h);
+        CHECK(terrain.mapped_tiles() == 2);
+    }
+    SUBCASE("world")
+    {
+        auto terrain{std::make_shared<Terrain>(path)};
+        auto earth{std::make_shared<World>(m_earth, r_earth, V3(1e6, -2e6, 3e5), V0,
+                                           rot(M1, units::deg(23.44)*Vy),
+                                           units::day(1.0))};
+        earth->step(1234.5);
+        auto [lat, lon] = std::make_tuple(units::deg(40.0), units::deg(-75.0));
+        Body satellite(1.0, M1, std::get<0>(earth->locate(lat, lon, 4e5)), V0, M1, V0);
+        Body deep(1.0, M1, std::get<0>(earth->locate(lat, lon, -1.0)), V0, M1, V0);
+        CHECK(earth->intersects(deep));
+        earth->set_terrain(terrain);
+        CHECK(earth->terrain() == terrain.get());
+        // Bodies far from the surface don't need the terrain.
+        CHECK(!earth->intersects(satellite));
+        CHECK(earth->intersects(deep));
+        CHECK(terrain->mapped_tiles() == 0);
+
+        CHECK(earth->terrain_height(0.0, 0.0) == 1000.0);
+        auto ground{earth->terrain_height(lat, lon)};
+        auto [r, o] = earth->locate(lat, lon, 0.0);
+        CHECK(close(mag(r - earth->r()), r_earth + ground, 1e-6));
+        auto [lat1, lon1, alt1] = earth->location(r);
+        CHECK(close(lat1, lat, 1e-12));
+        CHECK(close(lon1, lon, 1e-12));
+        CHECK(close(alt1, 0.0, 1e-6));
+
+        // Near the surface, the terrain decides.
+        Body above(1.0, M1, std::get<0>(earth->locate(lat, lon, 1.0)), V0, M1, V0);
+        Body below(1.0, M1, std::get<0>(earth->locate(lat, lon, -1.0)), V0, M1, V0);
+        CHECK(!earth->intersects(above));
+        CHECK(earth->intersects(below));
+        CHECK(terrain->mapped_tiles() == 2);
+
+        // Batches agree with single points.
+        Geo_Batch batch;
+        batch.resize(20);
+        for (std::size_t i = 0; i < batch.size(); ++i)
+        {
+            batch.lat[i] = units::deg(-80.0 + 8.0*i);
+            batch.lon[i] = units::deg(-170.0 + 17.0*i);
+            batch.alt[i] = 100.0*i;
+        }
+        earth->locate(batch);
+        for (std::size_t i = 0; i < batch.size(); ++i)
+        {
+            auto [r, o] = earth->locate(batch.lat[i], batch.lon[i], batch.alt[i]);
+            CHECK(close(V3(batch.x[i], batch.y[i], batch.z[i]), r, 1e-6));
+        }
+        auto alt{batch.alt};
+        earth->location(batch);
+        for (std::size_t i = 0; i < batch.size(); ++i)
+            CHECK(close(batch.alt[i], alt[i], 1e-6));
+
+        // Checkpoints keep the terrain.
+        Universe all(false);
+        all.add(earth);
+        std::stringstream ss;
+        REQUIRE(Checkpoint::save(all, ss));
+        auto copy{Checkpoint::load(ss)};
+        REQUIRE(copy);
+        auto copy_earth{std::dynamic_pointer_cast<World>(*copy->bodies().begin())};
+        REQUIRE(copy_earth->terrain());
+        CHECK(copy_earth->terrain()->path() == path);
+        CHECK(copy_earth->terrain_height(lat, lon) == ground);
+    }
+    std::remove(path);
+}
@@ -0,0 +1,91 @@
+#include "body.hh"
+#include "runner.hh"
+#include "test.hh"
+#include "trajectory.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+using namespace consts;
+
+TEST_CASE("trajectory")
+{
+    auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, rot(M1, 0.4*Vy),
+                                       units::day(1.0))};
+    auto [r_pad, m] = earth->locate(0.5, -1.4, 1);
+    auto pad{std::make_shared<Body>(10, M1, r_pad, V0, m, V0)};
+    auto sat{std::make_shared<Body>(1e3, M1, 2*r_earth*Vy, 5.6e3*Vx, rot(M1, 0.3*Vx),
+                                    1e-3*Vz)};
+    Universe all(false);
+    all.add(earth);
+    all.add(pad);
+    all.add(sat);
+    earth->capture(pad);
+
+    auto path{"test-trajectory.bin"};
+    {
+        Trajectory_Writer writer(path, 3, 2);
+        REQUIRE(writer.is_open());
+        Runner runner(all, 1.0);
+        runner.observe([&](Universe& u) { writer.observe(u); });
+        // Enough frames to make the file grow a few times.
+        runner.run(200.0);
+        CHECK(writer.frames() == 100);
+        writer.record(all);
+    }
+
+    Trajectory_Reader reader(path);
+    REQUIRE(reader.is_open());
+    CHECK(reader.bodies() == 3);
+    REQUIRE(reader.frames() == 101);
+
+    auto first{reader.frame(0)};
+    CHECK(first.time == 1.0);
+    CHECK(first.id[2] == 2);
+    CHECK(reader.frame(99).time == 199.0);
+    auto last{reader.frame(100)};
+    CHECK(last.time == 200.0);
+    CHECK(last.r(2) == sat->r());
+    CHECK(last.v(2) == sat->v_cm());
+    CHECK(close(last.orientation(2), sat->orientation(), 1e-12));
+    // Captured bodies are recorded in absolute coordinates.
+    CHECK(close(last.r(1), pad->transform_out(V0), 1e-6));
+    CHECK(last.v(1) == V0);
+    CHECK(close(last.orientation(1)*Vz, pad->rotate_out(Vz), 1e-12));
+
+    CHECK(reader.find(0.0) == 0);
+    CHECK(reader.find(50.0) == 24);
+    CHECK(reader.find(50.5) == 24);
+    CHECK(reader.frame(reader.find(51.0)).time == 51.0);
+    CHECK(reader.find(1e6) == 100);
+
+    SUBCASE("oversized")
+    {
+        // Counts whose products wrap to sizes that fit in the file.  The header has the
+        // number of bodies at byte 16, frames at 24, and the frame size at 32.
+        auto patch{[path](std::streamoff at, std::uint64_t value) {
+            std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+            fs.seekp(at);
+            fs.write(reinterpret_cast<char const*>(&value), sizeof(value));
+        }};
+        // 8(1 + 10·2⁶⁰) is 8 in 64 bits.
+        patch(16, std::uint64_t{1} << 60);
+        patch(32, 8);
+        CHECK(!Trajectory_Reader(path).is_open());
+        // 2⁶¹ frames of 8(1 + 10·3) bytes is 0 in 64 bits.
+        patch(16, 3);
+        patch(32, 248);
+        REQUIRE(Trajectory_Reader(path).is_open());
+        patch(24, std::uint64_t{1} << 61);
+        CHECK(!Trajectory_Reader(path).is_open());
+    }
+
+    std::remove(path);
+    CHECK(!Trajectory_Reader(path).is_open());
+}
@@ -100,3 +100,13 @@ TEST_CASE("2-body rotate diagonal")
     CHECK(close(b2->rotate_out(Vy), Vx, 1e-9));
     CHECK(close(b2->rotate_out(Vz), -Vz, 1e-9));
 }
+
+TEST_CASE("slerp")
+{
+    auto m1{rot(M1, deg(30)*Vx)};
+    auto m2{rot(m1, deg(60)*Vy)};
+    CHECK(close(slerp(m1, m2, 0.0)*Vz, m1*Vz, 1e-9));
+    CHECK(close(slerp(m1, m2, 1.0)*Vz, m2*Vz, 1e-9));
+    CHECK(close(slerp(m1, m2, 0.5)*Vz, rot(m1, deg(30)*Vy)*Vz, 1e-9));
+    CHECK(slerp(m1, m1, 0.5) == m1);
+}
@@ -0,0 +1,201 @@
+#include "body.hh"
+#include "test.hh"
+#include "units.hh"
+#include "universe.hh"
+
+#include "doctest.h"
+
+#include <cmath>
+#include <numbers>
+#include <tuple>
+#include <vector>
+
+/// @return A universe with two bodies that attract each other.
+static std::shared_ptr<Universe> pair()
+{
+    auto all{std::make_shared<Universe>(false)};
+    all->add(std::make_shared<Body>(1e10, M1, V0, V0, M1, V0));
+    all->add(std::make_shared<Body>(1e3, M1, 100*Vx, 0.1*Vy, M1, V0));
+    return all;
+}
+
+TEST_CASE("schedule")
+{
+    auto all{pair()};
+    std::vector<double> times;
+    all->schedule(0.25, [&](Universe& u) { times.push_back(u.time()); });
+    all->schedule(2.0, [&](Universe& u) { times.push_back(u.time()); });
+    CHECK(all->scheduled() == 2);
+    all->step(1.0);
+    CHECK(all->time() == 1.0);
+    CHECK(times == std::vector<double>{0.25});
+    CHECK(all->scheduled() == 1);
+    all->step(1.0);
+    CHECK(times == std::vector<double>{0.25, 2.0});
+    CHECK(all->scheduled() == 0);
+
+    SUBCASE("split")
+    {
+        // An action in the middle of a long step has the same effect as short steps that
+        // meet at the action's time.
+        auto kick{[](Universe& u) { u.bodies().back()->impulse(1e3*Vx); }};
+        auto u1{pair()};
+        u1->schedule(0.25, kick);
+        u1->step(1.0);
+        auto u2{pair()};
+        u2->step(0.25);
+        kick(*u2);
+        u2->step(0.75);
+        CHECK(u1->time() == u2->time());
+        CHECK(u1->bodies().back()->r() == u2->bodies().back()->r());
+        CHECK(u1->bodies().back()->v_cm() == u2->bodies().back()->v_cm());
+    }
+    SUBCASE("order")
+    {
+        // Same-time actions run in the order scheduled, and actions can schedule more.
+        std::vector<int> order;
+        all->schedule(3.0, [&](Universe&) { order.push_back(1); });
+        all->schedule(3.0, [&](Universe& u) {
+            order.push_back(2);
+            u.schedule(3.0, [&](Universe&) { order.push_back(4); });
+            u.schedule(3.5, [&](Universe&) { order.push_back(5); });
+        });
+        all->schedule(3.0, [&](Universe&) { order.push_back(3); });
+        all->step(1.0);
+        CHECK(order == std::vector<int>{1, 2, 3, 4});
+        all->step(1.0);
+        CHECK(order == std::vector<int>{1, 2, 3, 4, 5});
+    }
+    SUBCASE("past")
+    {
+        // A late action runs at the start of the next step.
+        all->schedule(1.0, [&](Universe& u) { times.push_back(u.time()); });
+        all->step(0.5);
+        CHECK(times.back() == 2.0);
+        CHECK(all->time() == 2.5);
+    }
+}
+
+TEST_CASE("floating origin")
+{
+    auto u1{pair()};
+    auto u2{pair()};
+    auto anchor{u2->bodies().back()};
+    u2->set_floating_origin(anchor, 50.0);
+    CHECK(u2->origin() == V0);
+    for (int i = 0; i < 100; ++i)
+    {
+        u1->step(0.1);
+        u2->step(0.1);
+    }
+    // The origin moved to the anchor and stayed near it.
+    CHECK(close(u2->origin(), 100*Vx, 1.0));
+    CHECK(mag(anchor->r_cm()) < 50.0);
+    // Nothing moved in absolute terms.
+    auto check_same{[&]() {
+        for (auto it1{u1->bodies().begin()}, it2{u2->bodies().begin()};
+             it1 != u1->bodies().end(); ++it1, ++it2)
+        {
+            CHECK(close(u2->origin() + (*it2)->r(), (*it1)->r(), 1e-9));
+            CHECK(close((*it2)->v_cm(), (*it1)->v_cm(), 1e-12));
+        }
+    }};
+    check_same();
+
+    u2->rebase(V3(-1e3, 2e3, 0.0));
+    CHECK(close(anchor->r(), V3(1e3, -2e3, 0.0), 50.0));
+    check_same();
+    u2->set_floating_origin(nullptr, 0.0);
+    u1->step(1.0);
+    u2->step(1.0);
+    CHECK(mag(anchor->r_cm()) > 50.0);
+    check_same();
+}
+
+TEST_CASE("compensated summation")
+{
+    // Small increments to large values lose bits in every plain addition.
+    auto run{[](Universe::Summation summation) {
+        auto all{std::make_shared<Universe>(false)};
+        all->set_summation(summation);
+        auto far{std::make_shared<Body>(1.0, M1, 4e8*Vx, 0.1*Vx, M1, V0)};
+        auto fast{std::make_shared<Body>(1.0, M1, -4e8*Vx, 1e3*Vy, M1, V0)};
+        all->add(far);
+        all->add(fast);
+        for (int i = 0; i < 100000; ++i)
+        {
+            all->step(0.1);
+            fast->impulse(1e-14*Vy);
+        }
+        return std::make_tuple(all->time(), far->r().x - 4e8, fast->v_cm().y - 1e3);
+    }};
+    auto [t1, dx1, dv1] = run(Universe::Summation::plain);
+    auto [t2, dx2, dv2] = run(Universe::Summation::compensated);
+    CHECK(std::abs(t1 - 1e4) > 1e-9);
+    CHECK(std::abs(t2 - 1e4) < 1e-11);
+    CHECK(std::abs(dx1 - 1e3) > 1e-4);
+    CHECK(std::abs(dx2 - 1e3) < 1e-7);
+    // Each impulse is less than half an ulp of the velocity.
+    CHECK(dv1 == 0.0);
+    CHECK(close(dv2, 1e-9, 2e-13));
+
+    auto all{pair()};
+    CHECK(all->summation() == Universe::Summation::plain);
+    CHECK(!all->bodies().front()->is_compensated());
+    all->set_summation(Universe::Summation::compensated);
+    CHECK(all->bodies().front()->is_compensated());
+    all->add(std::make_shared<Body>(1.0, M1, V0, V0, M1, V0));
+    CHECK(all->bodies().back()->is_compensated());
+}
+
+TEST_CASE("diagnostics")
+{
+    using consts::G;
+    double const m1{1e15};
+    double const m2{1e3};
+    double const a{1e3};
+    auto v{std::sqrt(G*m1/a)};
+    auto all{std::make_shared<Universe>(false)};
+    auto b1{std::make_shared<Body>(m1, M1, V0, V0, M1, V0)};
+    auto b2{std::make_shared<Body>(m2, M1, a*Vx, v*Vy, M1, 1e-3*Vz)};
+    all->add(b1);
+    all->add(b2);
+    all->step(1.0);
+    // Off by default.
+    CHECK(all->diagnostics().energy() == 0.0);
+
+    all->set_diagnostics(true);
+    auto v1{b1->v_cm()};
+    auto v2{b2->v_cm()};
+    // Taken halfway through the step.
+    auto r{b2->r_cm() - b1->r_cm() + 0.5*(v2 - v1)};
+    auto spin{0.5*dot(b2->omega(), b2->I()*b2->omega())};
+    all->step(1.0);
+    auto const& d{all->diagnostics()};
+    CHECK(d.time == 1.5);
+    CHECK(close(d.potential, -G*m1*m2/mag(r), 1e-12*G*m1*m2/mag(r)));
+    CHECK(close(d.kinetic, 0.5*m1*dot(v1, v1) + 0.5*m2*dot(v2, v2) + spin, 1e-12));
+    CHECK(close(d.momentum, m1*v1 + m2*v2, 1e-9));
+    CHECK(all->drift().time == 0.0);
+    all->step(1.0);
+    CHECK(all->drift().time == 1.0);
+    CHECK(all->diagnostics().time == 2.5);
+
+    // Gravity conserves the totals over an orbit.
+    auto d0{all->diagnostics()};
+    auto period{2*std::numbers::pi*a/v};
+    for (int i = 0; i < static_cast<int>(period); ++i)
+    {
+        all->step(1.0);
+        CHECK(std::abs(all->drift().energy()) < 1e-6*std::abs(d0.potential));
+    }
+    auto d1{all->diagnostics()};
+    CHECK(close(d1.energy(), d0.energy(), 1e-4*std::abs(d0.potential)));
+    CHECK(close(d1.momentum, d0.momentum, 1e-9*m2*v));
+    CHECK(close(d1.angular_momentum, d0.angular_momentum, 1e-9*m2*v*a));
+
+    // Angular momentum is about the absolute origin, so rebasing doesn't change it.
+    all->rebase(V3(1e4, 2e4, 0.0));
+    all->step(1.0);
+    CHECK(close(all->drift().angular_momentum, V0, 1e-9*m2*v*a));
+}
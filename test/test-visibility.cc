@@ -0,0 +1,161 @@
+#include "body.hh"
+#include "runner.hh"
+#include "test.hh"
+#include "trajectory.hh"
+#include "units.hh"
+#include "universe.hh"
+#include "visibility.hh"
+#include "world.hh"
+
+#include "doctest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+using namespace consts;
+
+TEST_CASE("visibility")
+{
+    auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0,
+                                       rot(M1, units::deg(23.44)*Vy), units::day(1.0))};
+    double const a{7e6};
+    auto v{std::sqrt(G*m_earth/a)};
+    auto incl{units::deg(60.0)};
+    auto sat1{std::make_shared<Body>(1e3, M1, a*Vx, v*V3(0.0, std::cos(incl),
+                                                          std::sin(incl)), M1, V0)};
+    auto sat2{std::make_shared<Body>(1e3, M1, -a*Vy, v*Vx, M1, V0)};
+    Universe all(false);
+    all.add(earth);
+    all.add(sat1);
+    all.add(sat2);
+
+    // Record a frame every minute, and keep the exact elevations of the first satellite
+    // from a station under its path at 1 hour.
+    double const step{10.0};
+    double const duration{3*3600.0};
+    auto path{"test-visibility.bin"};
+    auto [lat0, lon0, alt0] = earth->location(sat1->r_cm());
+    Station under{0.0, 0.0, 100.0, units::deg(10.0)};
+    double alt_1h{0.0};
+    std::vector<std::tuple<double, V3, V3, M3>> states;
+    {
+        Trajectory_Writer writer(path, 3, 6);
+        Runner runner(all, step);
+        runner.observe([&](Universe& u) {
+            writer.observe(u);
+            if (u.time() == 3600.0)
+                std::tie(under.lat, under.lon, alt_1h) = earth->location(sat1->r_cm());
+            states.emplace_back(u.time(), sat1->r_cm(), earth->r(), earth->orientation());
+        });
+        runner.run(duration);
+    }
+    Trajectory_Reader reader(path);
+    REQUIRE(reader.is_open());
+    Visibility vis(reader, 0, r_earth);
+    // The first step is recorded.
+    CHECK(vis.start() == step);
+    CHECK(vis.end() == duration - 5*step);
+
+    SUBCASE("elevation")
+    {
+        // Compare with the station's elevation in the universe at every step.  Between
+        // frames, the curves miss the integrated path by a few meters.
+        auto [r_st, o_st] = earth->locate(under.lat, under.lon, under.alt);
+        for (auto const& [t, r_sat, r_earth_t, o_earth] : states)
+        {
+            if (t < vis.start())
+                continue;
+            // The station at time t.
+            auto r{r_earth_t + o_earth*earth->transform_in(r_st)};
+            auto up{o_earth*earth->rotate_in(o_st*Vz)};
+            auto expected{std::asin(dot(up, unit(r_sat - r)))};
+            auto on_frame{std::fmod(t - step, 6*step) == 0.0};
+            CHECK(close(vis.elevation(1, under, t), expected, on_frame ? 1e-9 : 1e-4));
+        }
+    }
+    SUBCASE("ground track")
+    {
+        auto tracks{vis.ground_tracks({1, 2}, {60.0, 95.0, 3600.0}, 2)};
+        REQUIRE(tracks.size() == 2);
+        REQUIRE(tracks[0].size() == 3);
+        CHECK(close(tracks[0].lat[2], under.lat, 1e-5));
+        CHECK(close(tracks[0].lon[2], under.lon, 1e-5));
+        CHECK(close(tracks[0].alt[2], alt_1h, 10.0));
+        // The second satellite orbits in the plane of the Earth's tilt.
+        for (std::size_t i = 0; i < 3; ++i)
+            CHECK(std::abs(tracks[1].lat[i]) < units::deg(23.44));
+        auto [lat, lon, alt] = vis.location(1, 95.0);
+        CHECK(tracks[0].lat[1] == lat);
+        CHECK(tracks[0].lon[1] == lon);
+        V3 r{tracks[0].x[1], tracks[0].y[1], tracks[0].z[1]};
+        CHECK(r == vis.position(1, 95.0));
+    }
+    SUBCASE("passes")
+    {
+        // The first satellite starts in view of a station beneath it.
+        Station start{lat0, lon0, 0.0, 0.0};
+        std::vector<Station> stations{under, start, {units::deg(-80.0), 0.0, 0.0, 0.0}};
+        auto passes{vis.passes({1, 2}, stations, 1e-3, 3)};
+        CHECK(passes == vis.passes({1, 2}, stations, 1e-3, 1));
+        REQUIRE(!passes.empty());
+
+        // Find the passes by sampling every second and check that none are missed.
+        std::vector<Pass> sampled;
+        for (std::size_t sat : {1, 2})
+            for (std::size_t st = 0; st < stations.size(); ++st)
+            {
+                auto const& station{stations[st]};
+                auto above{[&](double t) {
+                    return vis.elevation(sat, station, t) > station.min_elevation;
+                }};
+                auto in_view{above(vis.start())};
+                auto rise{vis.start()};
+                for (auto t{vis.start() + 1.0}; t <= vis.end(); t += 1.0)
+                {
+                    if (above(t) == in_view)
+                        continue;
+                    if (in_view)
+                        sampled.push_back({sat, st, rise, t, 0.0, 0.0});
+                    else
+                        rise = t;
+                    in_view = !in_view;
+                }
+                if (in_view)
+                    sampled.push_back({sat, st, rise, vis.end(), 0.0, 0.0});
+            }
+        REQUIRE(passes.size() == sampled.size());
+        for (std::size_t i = 0; i < passes.size(); ++i)
+        {
+            auto const& p{passes[i]};
+            CHECK(p.satellite == sampled[i].satellite);
+            CHECK(p.station == sampled[i].station);
+            CHECK(close(p.rise, sampled[i].rise, 1.0));
+            CHECK(close(p.set, sampled[i].set, 1.0));
+            CHECK(p.rise < p.culmination);
+            CHECK(p.culmination < p.set);
+            auto const& st{stations[p.station]};
+            if (p.rise > vis.start())
+                CHECK(close(vis.elevation(p.satellite, st, p.rise), st.min_elevation,
+                            1e-5));
+            CHECK(close(vis.elevation(p.satellite, st, p.culmination), p.max_elevation,
+                        1e-9));
+        }
+        CHECK(passes[0].satellite == 1);
+        // The pass under the satellite at 1 hour goes nearly overhead.
+        auto overhead{std::find_if(passes.begin(), passes.end(), [](Pass const& p) {
+            return p.station == 0 && p.rise < 3600.0 && p.set > 3600.0;
+        })};
+        REQUIRE(overhead != passes.end());
+        CHECK(overhead->max_elevation > units::deg(85.0));
+        // The satellite starts in view of the station beneath it.
+        auto first{std::find_if(passes.begin(), passes.end(),
+                                [](Pass const& p) { return p.station == 1; })};
+        REQUIRE(first != passes.end());
+        CHECK(first->rise == vis.start());
+    }
+    std::remove(path);
+}
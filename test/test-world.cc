@@ -151,3 +151,43 @@ TEST_CASE("locate")
         CHECK(close(o*Vz, -Vx, 1e-9));
     }
 }
+
+TEST_CASE("batch geodetic")
+{
+    using units::deg;
+    auto earth = std::make_shared<World>(m_earth, r_earth, V3(1e6, -2e6, 3e5), V0,
+                                         rot(M1, deg(23.44)*Vy), units::day(1.0));
+    earth->step(1234.5);
+
+    Geo_Batch batch;
+    batch.resize(50);
+    CHECK(batch.size() == 50);
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        batch.lat[i] = deg(-85.0 + 3.4*i);
+        batch.lon[i] = deg(-175.0 + 7.1*i);
+        batch.alt[i] = 1e3*i;
+    }
+    earth->locate(batch);
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        auto [r, o] = earth->locate(batch.lat[i], batch.lon[i], batch.alt[i]);
+        CHECK(close(V3(batch.x[i], batch.y[i], batch.z[i]), r, 1e-6));
+    }
+
+    // Round trip.
+    auto lat{batch.lat};
+    auto lon{batch.lon};
+    auto alt{batch.alt};
+    earth->location(batch);
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        CHECK(close(batch.lat[i], lat[i], 1e-12));
+        CHECK(close(batch.lon[i], lon[i], 1e-12));
+        CHECK(close(batch.alt[i], alt[i], 1e-6));
+        auto [lat1, lon1, alt1] = earth->location(V3(batch.x[i], batch.y[i], batch.z[i]));
+        CHECK(close(batch.lat[i], lat1, 1e-12));
+        CHECK(close(batch.lon[i], lon1, 1e-12));
+        CHECK(close(batch.alt[i], alt1, 1e-6));
+    }
+}
@@ -15,6 +15,7 @@
 
 #include <body.hh>
 #include <rocket.hh>
+#include <runner.hh>
 #include <units.hh>
 #include <universe.hh>
 #include <world.hh>
@@ -102,6 +103,7 @@ int main(int argc, char** argv)
     sf::Texture earth_tex;
     if (!earth_tex.loadFromFile("earth-texture.png"))
         exit(2);
+    Runner runner(all, 10.0);
     sf::Clock clock;
     bool running = true;
     while (running)
@@ -128,7 +130,7 @@ int main(int argc, char** argv)
         }
 
         auto elapsed = clock.restart().asSeconds();
-        all.step(1e4*elapsed);
+        runner.advance(1e4*elapsed);
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glLoadIdentity();
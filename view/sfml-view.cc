@@ -15,6 +15,8 @@
 
 #include <body.hh>
 #include <rocket.hh>
+#include <runner.hh>
+#include <triple-buffer.hh>
 #include <units.hh>
 #include <universe.hh>
 #include <world.hh>
@@ -25,12 +27,16 @@
 #include <SFML/OpenGL.hpp>
 #include <SFML/Window.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <numbers>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 using namespace std::numbers;
@@ -79,10 +85,40 @@ struct View
     double mag;
 };
 
-void draw(std::shared_ptr<Rocket> rocket, GLUquadric* quad, double mag)
+/// Position and orientation of a body.
+struct Pose
 {
-    auto r{rocket->r()};
-    auto [axis, angle] = axis_angle(rocket->orientation());
+    V3 r;
+    M3 orientation;
+};
+
+/// The state the renderer needs, copied from the simulation thread.
+struct Snapshot
+{
+    double time{0.0};
+    Pose earth{V0, M1};
+    Pose rocket{V0, M1};
+    V3 rocket_v{V0};
+    double fuel{0.0};
+    /// The rocket's absolute position.
+    V3 air{V0};
+    /// The point on the Earth's surface below the rocket in the Earth's frame.
+    V3 ground{V0};
+    /// The rocket's longitude, latitude, and altitude.
+    V3 map{V0};
+    Pose pad{V0, M1};
+};
+
+/// @return The pose a fraction t of the way from p1 to p2.
+Pose interpolate(Pose const& p1, Pose const& p2, double t)
+{
+    return {p1.r + t*(p2.r - p1.r), slerp(p1.orientation, p2.orientation, t)};
+}
+
+void draw(Pose const& rocket, GLUquadric* quad, double mag)
+{
+    auto r{rocket.r};
+    auto [axis, angle] = axis_angle(rocket.orientation);
 
     glPushMatrix();
     glColor3d(0.2, 0.8, 0.2);
@@ -95,16 +131,16 @@ void draw(std::shared_ptr<Rocket> rocket, GLUquadric* quad, double mag)
     glPopMatrix();
 }
 
-void draw(std::shared_ptr<World> world, GLUquadric* quad, std::vector<V3> const& ground)
+void draw(Pose const& world, double radius, GLUquadric* quad, std::vector<V3> const& ground)
 {
-    auto r{world->r()};
-    auto [axis, angle] = axis_angle(world->orientation());
+    auto r{world.r};
+    auto [axis, angle] = axis_angle(world.orientation);
 
     glPushMatrix();
     glColor3d(1.0, 1.0, 1.0);
     glTranslated(r.x, r.y, r.z);
     glRotated((180.0/pi)*angle, axis.x, axis.y, axis.z);
-    gluSphere(quad, world->radius(), 128, 128);
+    gluSphere(quad, radius, 128, 128);
     glColor3f(1.0, 0.0, 1.0);
     glBegin(GL_LINE_STRIP);
     for (auto& v : ground)
@@ -153,6 +189,8 @@ int main(int argc, char** argv)
     auto orientation{rot(M1, units::deg(23.44)*Vy)};
     auto earth{std::make_shared<World>(m_earth, r_earth, V0, V0, orientation,
                                        units::day(1.0))};
+    // No atmosphere.  The scripted rocket weighs 70 kg for a 1-m-wide, 10-m-long hull.
+    // With that hull's drag it falls back from about 20 km instead of reaching orbit.
     auto ksc_lat{units::dms(28, 31, 27)};
     auto ksc_lon{units::dms(-80, 39, 03)};
     auto [r_pad, m] = earth->locate(ksc_lat, ksc_lon, 1);
@@ -164,6 +202,10 @@ int main(int argc, char** argv)
     all.add(body);
 
     earth->capture(body);
+    // Lift off, pitch over, and straighten out at exactly the scripted times.
+    all.schedule(1, [&](Universe&) { earth->release(body); });
+    all.schedule(110, [&](Universe&) { body->orient_thrust(-2e-5*Vy); });
+    all.schedule(142, [&](Universe&) { body->orient_thrust(V0); });
 
     std::array views {
         View(0.0, 0.5, 0.5, 0.5, Vz, V0, Vy, 1/(1.5*r_earth)),
@@ -200,9 +242,48 @@ int main(int argc, char** argv)
     sf::Texture earth_tex;
     if (!earth_tex.loadFromFile("earth-texture.png"))
         exit(2);
-    sf::Clock clock;
-    bool running = true;
-    int stage = 0;
+
+    // Copy the state that the renderer needs.
+    auto take_snapshot = [&](Snapshot& snap) {
+        snap.time = all.time();
+        snap.earth = {earth->r(), earth->orientation()};
+        snap.rocket = {body->r(), body->orientation()};
+        snap.rocket_v = body->v_cm();
+        snap.fuel = body->fuel_volume();
+        auto r{body->transform_out(V0)};
+        snap.air = r;
+        snap.ground = 1.01*earth->radius()*unit(earth->transform_in(r - earth->r()));
+        auto [lat, lon, alt] = earth->location(r);
+        snap.map = V3(lon, lat, alt); // longitude 1st because it's x-like.
+        auto [r_pad, m] = earth->locate(ksc_lat, ksc_lon, 1);
+        snap.pad = {r_pad, m};
+    };
+
+    // The two most recent snapshots and when they arrived.  The renderer interpolates
+    // between them.
+    using Clock = std::chrono::steady_clock;
+    Snapshot previous;
+    take_snapshot(previous);
+    auto latest{previous};
+    auto previous_arrival{Clock::now()};
+    auto latest_arrival{previous_arrival};
+
+    // The simulation runs on its own thread with a fixed time step so that the flight
+    // doesn't depend on the frame rate and slow frames don't hold up the physics.
+    // Snapshots of the state are handed to the renderer without locking.
+    Triple_Buffer<Snapshot> snapshots;
+    std::atomic<bool> running = true;
+    std::jthread simulation([&]() {
+        Runner runner(all, 0.1);
+        runner.set_pacing(1e2);
+        runner.observe([&](Universe&) {
+            take_snapshot(snapshots.back());
+            snapshots.publish();
+        });
+        while (running)
+            runner.run(1.0);
+    });
+
     int n = 0;
     while (running)
     {
@@ -229,43 +310,32 @@ int main(int argc, char** argv)
             }
         }
 
-        auto elapsed = clock.restart().asSeconds();
-        all.step(1e2*elapsed);
-        auto r = body->transform_out(V0);
-        if (all.time() > 1 && stage == 0)
-        {
-            // std::cout << "go" << std::endl;
-            earth->release(body);
-            ++stage;
-        }
-        else if (all.time() > 110 && stage == 1)
+        auto now{Clock::now()};
+        if (snapshots.update())
         {
-            // std::cout << "turn" << std::endl;
-            body->orient_thrust(-2e-5*Vy);
-            ++stage;
-        }
-        else if (all.time() > 110 && stage == 2)
-        {
-            // std::cout << "unturn" << std::endl;
-            // body->orient_thrust(-1e-4*Vy);
-            ++stage;
-        }
-        else if (all.time() > 142 && stage == 3)
-        {
-            // std::cout << "straight" << std::endl;
-            body->orient_thrust(V0);
-            ++stage;
-        }
+            previous = latest;
+            previous_arrival = latest_arrival;
+            latest = snapshots.front();
+            latest_arrival = now;
 
-        // Add tracking points at intervals to avoid filling the vectors.
-        if (n++ == 10)
-        {
-            n = 0;
-            air.push_back(r);
-            ground.push_back(1.01*earth->radius()*unit(earth->transform_in(r - earth->r())));
-            auto [lat, lon, alt] = earth->location(r);
-            map.push_back(V3(lon, lat, alt)); // longitude 1st because it's x-like.
+            // Add tracking points at intervals to avoid filling the vectors.
+            if (n++ == 10)
+            {
+                n = 0;
+                air.push_back(latest.air);
+                ground.push_back(latest.ground);
+                map.push_back(latest.map);
+            }
         }
+        // Move from the previous snapshot to the latest over the time it took the latest
+        // one to arrive.
+        std::chrono::duration<double> since{now - latest_arrival};
+        std::chrono::duration<double> interval{latest_arrival - previous_arrival};
+        auto t{interval.count() > 0.0
+            ? std::clamp(since.count()/interval.count(), 0.0, 1.0) : 1.0};
+        auto earth_pose{interpolate(previous.earth, latest.earth, t)};
+        auto rocket_pose{interpolate(previous.rocket, latest.rocket, t)};
+        auto pad{interpolate(previous.pad, latest.pad, t)};
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         for (auto const& v : views)
@@ -286,9 +356,8 @@ int main(int argc, char** argv)
             // 3D views
             double dim = std::min(w, h)*v.mag;
             glOrtho(-w/dim, w/dim, -h/dim, h/dim, -2/v.mag, 2*r_earth);
-            auto at = v.at == V0 ? v.at : body->r();
-            auto [r_pad, m] = earth->locate(ksc_lat, ksc_lon, 1);
-            auto eye = v.at == V0 ? v.eye : m*v.eye + r_pad + v.eye;
+            auto at = v.at == V0 ? v.at : rocket_pose.r;
+            auto eye = v.at == V0 ? v.eye : pad.orientation*v.eye + pad.r + v.eye;
             gluLookAt(eye.x, eye.y, eye.z, at.x, at.y, at.z, v.up.x, v.up.y, v.up.z);
 
             glColor3f(1.0, 1.0, 0.0);
@@ -298,17 +367,17 @@ int main(int argc, char** argv)
             glEnd();
 
             sf::Texture::bind(&earth_tex);
-            draw(earth, earth_quad, ground);
-            draw(body, body_quad, v.mag);
+            draw(earth_pose, earth->radius(), earth_quad, ground);
+            draw(rocket_pose, body_quad, v.mag);
 
             glPushMatrix();
             glLoadIdentity();
             sf::Texture::bind(nullptr);
             glOrtho(0, width, 0, height, -1, 1);
             draw_text(0, height-30, "", v.eye);
-            draw_text(0, 0, "Vel:", 1e-3*mag(body->v_cm()), "km/s", 3);
-            draw_text(0, 20, "Alt:", 1e-3*(mag(body->r()) - earth->radius()), "km", 0);
-            draw_text(0, 40, "Fuel:", body->fuel_volume(), "m^3", 3);
+            draw_text(0, 0, "Vel:", 1e-3*mag(latest.rocket_v), "km/s", 3);
+            draw_text(0, 20, "Alt:", 1e-3*(mag(rocket_pose.r) - earth->radius()), "km", 0);
+            draw_text(0, 40, "Fuel:", latest.fuel, "m^3", 3);
             glPopMatrix();
         }
         glFlush();